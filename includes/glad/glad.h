@@ -7,15 +7,16 @@
     APIs: gl=4.5
     Profile: compatibility
     Extensions:
-        GL_KHR_debug
+        GL_KHR_debug,
+        GL_KHR_parallel_shader_compile
     Loader: True
     Local files: False
     Omit khrplatform: False
 
     Commandline:
-        --profile="compatibility" --api="gl=4.5" --generator="c" --spec="gl" --extensions="GL_KHR_debug"
+        --profile="compatibility" --api="gl=4.5" --generator="c" --spec="gl" --extensions="GL_KHR_debug,GL_KHR_parallel_shader_compile"
     Online:
-        http://glad.dav1d.de/#profile=compatibility&language=c&specification=gl&loader=on&api=gl%3D4.5&extensions=GL_KHR_debug
+        http://glad.dav1d.de/#profile=compatibility&language=c&specification=gl&loader=on&api=gl%3D4.5&extensions=GL_KHR_debug&extensions=GL_KHR_parallel_shader_compile
 */
 
 
@@ -5197,6 +5198,8 @@ GLAPI PFNGLTEXTUREBARRIERPROC glad_glTextureBarrier;
 #define GL_DEBUG_SEVERITY_LOW_KHR 0x9148
 #define GL_DEBUG_OUTPUT_KHR 0x92E0
 #define GL_CONTEXT_FLAG_DEBUG_BIT_KHR 0x00000002
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
 #define GL_STACK_OVERFLOW_KHR 0x0503
 #define GL_STACK_UNDERFLOW_KHR 0x0504
 #ifndef GL_KHR_debug
@@ -5236,6 +5239,13 @@ typedef void (APIENTRYP PFNGLGETPOINTERVKHRPROC)(GLenum pname, void **params);
 GLAPI PFNGLGETPOINTERVKHRPROC glad_glGetPointervKHR;
 #define glGetPointervKHR glad_glGetPointervKHR
 #endif
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_KHR_parallel_shader_compile 1
+GLAPI int GLAD_GL_KHR_parallel_shader_compile;
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+GLAPI PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glad_glMaxShaderCompilerThreadsKHR
+#endif
 
 #ifdef __cplusplus
 }
@@ -7,6 +7,10 @@
 
 #include <vector>
 
+#ifdef LEARNOPENGL_HEADLESS
+#include <learnopengl/headless.h>
+#endif
+
 // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
 enum Camera_Movement {
     FORWARD,
@@ -49,6 +53,9 @@ public:
         Yaw = yaw;
         Pitch = pitch;
         updateCameraVectors();
+#ifdef LEARNOPENGL_HEADLESS
+        headlessAttachCamera(this);
+#endif
     }
     // Constructor with scalar values
     Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
@@ -58,6 +65,9 @@ public:
         Yaw = yaw;
         Pitch = pitch;
         updateCameraVectors();
+#ifdef LEARNOPENGL_HEADLESS
+        headlessAttachCamera(this);
+#endif
     }
 
     // Returns the view matrix calculated using Euler Angles and the LookAt Matrix
@@ -0,0 +1,115 @@
+#ifndef FRAME_DATA_H
+#define FRAME_DATA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/stream_buffer.h>
+
+#include <cstring>
+
+// The data every pass of a frame shares, in one uniform block instead of a copy of the camera matrices in each
+// program's uniforms: FrameData::shared().update() uploads it once per frame and binds it to FRAME_DATA_BINDING,
+// and Shader binds the FrameData block of every program it links to that point. A shader gets the block with
+//     #include "frame_data.glsl"
+// which Shader provides without a file (see glsl()), and then reads view, projection, cameraPosition, ... as if
+// they were its own uniforms.
+// The block is written round-robin into a StreamBuffer, so updating it never waits for the GPU to finish the frames
+// still reading the previous values.
+// ------------------------------------------------------------------------------------------------------
+// high enough to stay clear of the binding points the demos pick for their own blocks
+const unsigned int FRAME_DATA_BINDING = 15;
+
+// the block's std140 layout
+struct FrameDataBlock
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::mat4 inverseView;
+    glm::mat4 inverseProjection;
+    glm::mat4 inverseViewProjection;
+    glm::vec3 cameraPosition;
+    float time;               // seconds, as passed to update()
+    glm::vec2 screenSize;     // in pixels
+    glm::vec2 inverseScreenSize;
+};
+static_assert(sizeof(FrameDataBlock) == 6 * 64 + 32, "FrameDataBlock must match the std140 layout of the FrameData block");
+
+class FrameData
+{
+public:
+    // the values of the last update()
+    FrameDataBlock data;
+
+    static FrameData &shared()
+    {
+        static FrameData frameData;
+        return frameData;
+    }
+
+    FrameData() : buffer(NULL)
+    {
+        std::memset(&data, 0, sizeof(data));
+    }
+
+    // call once per frame before drawing, and again whenever the camera changes within a frame
+    void update(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &cameraPosition, float time,
+                unsigned int width, unsigned int height)
+    {
+        data.view = view;
+        data.projection = projection;
+        data.viewProjection = projection * view;
+        data.inverseView = glm::inverse(view);
+        data.inverseProjection = glm::inverse(projection);
+        data.inverseViewProjection = glm::inverse(data.viewProjection);
+        data.cameraPosition = cameraPosition;
+        data.time = time;
+        data.screenSize = glm::vec2((float)width, (float)height);
+        data.inverseScreenSize = glm::vec2(1.0f / width, 1.0f / height);
+
+        if (buffer == NULL)
+        {
+            // regions have to start at multiples of the uniform buffer offset alignment. The buffer lives as long
+            // as the context, it's never deleted since the shared instance outlives it.
+            GLint alignment = 256;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            GLsizeiptr size = ((GLsizeiptr)sizeof(FrameDataBlock) + alignment - 1) / alignment * alignment;
+            buffer = new StreamBuffer(GL_UNIFORM_BUFFER, size);
+        }
+        else
+        {
+            // everything drawn since the last update read the previous region
+            buffer->fence();
+        }
+        std::memcpy(buffer->map(), &data, sizeof(data));
+        buffer->unmap();
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, buffer->ID, buffer->offset(), sizeof(FrameDataBlock));
+    }
+
+    // the GLSL declaration of the block, included as "frame_data.glsl"
+    static const char *glsl()
+    {
+        return
+            "layout (std140) uniform FrameData\n"
+            "{\n"
+            "    mat4 view;\n"
+            "    mat4 projection;\n"
+            "    mat4 viewProjection;\n"
+            "    mat4 inverseView;\n"
+            "    mat4 inverseProjection;\n"
+            "    mat4 inverseViewProjection;\n"
+            "    vec3 cameraPosition;\n"
+            "    float time;\n"
+            "    vec2 screenSize;\n"
+            "    vec2 inverseScreenSize;\n"
+            "};\n";
+    }
+
+private:
+    StreamBuffer *buffer;
+
+    FrameData(const FrameData&);
+    FrameData &operator=(const FrameData&);
+};
+#endif
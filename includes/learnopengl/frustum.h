@@ -0,0 +1,92 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// The six clipping planes of a camera, extracted from its projection * view matrix (Gribb & Hartmann), used to
+// skip geometry that can't end up on screen. Plane normals point into the frustum, so a point p is inside a
+// plane when dot(plane.xyz, p) + plane.w >= 0.
+// Build a new Frustum whenever the camera changes, e.g. once per frame: Frustum frustum(projection * view);
+// The counters are meant for statistics: whatever draws with the frustum adds the meshes it tested and culled.
+// ------------------------------------------------------------------------------------------------------
+enum Frustum_Plane {
+    FRUSTUM_LEFT,
+    FRUSTUM_RIGHT,
+    FRUSTUM_BOTTOM,
+    FRUSTUM_TOP,
+    FRUSTUM_NEAR,
+    FRUSTUM_FAR
+};
+
+class Frustum
+{
+public:
+    glm::vec4 planes[6];
+    // number of meshes tested against and culled by this frustum
+    unsigned int meshesTested;
+    unsigned int meshesCulled;
+
+    Frustum(const glm::mat4 &projectionView = glm::mat4(1.0f)) : meshesTested(0), meshesCulled(0)
+    {
+        // glm matrices are column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+        glm::vec4 row0(projectionView[0][0], projectionView[1][0], projectionView[2][0], projectionView[3][0]);
+        glm::vec4 row1(projectionView[0][1], projectionView[1][1], projectionView[2][1], projectionView[3][1]);
+        glm::vec4 row2(projectionView[0][2], projectionView[1][2], projectionView[2][2], projectionView[3][2]);
+        glm::vec4 row3(projectionView[0][3], projectionView[1][3], projectionView[2][3], projectionView[3][3]);
+        planes[FRUSTUM_LEFT]   = row3 + row0;
+        planes[FRUSTUM_RIGHT]  = row3 - row0;
+        planes[FRUSTUM_BOTTOM] = row3 + row1;
+        planes[FRUSTUM_TOP]    = row3 - row1;
+        planes[FRUSTUM_NEAR]   = row3 + row2;
+        planes[FRUSTUM_FAR]    = row3 - row2;
+        // normalize so the plane equation gives actual distances, which the sphere test relies on
+        for (int i = 0; i < 6; i++)
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+
+    void ResetCounters()
+    {
+        meshesTested = meshesCulled = 0;
+    }
+
+    // sphere in world space
+    bool IntersectsSphere(const glm::vec3 &center, float radius) const
+    {
+        for (int i = 0; i < 6; i++)
+            if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+                return false;
+        return true;
+    }
+
+    // axis aligned box in world space
+    bool IntersectsBox(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const
+    {
+        glm::vec3 center = (boxMin + boxMax) * 0.5f;
+        glm::vec3 extents = (boxMax - boxMin) * 0.5f;
+        for (int i = 0; i < 6; i++)
+        {
+            glm::vec3 normal(planes[i]);
+            // projected radius of the box onto the plane normal
+            float radius = glm::dot(extents, glm::abs(normal));
+            if (glm::dot(normal, center) + planes[i].w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // model space box and its bounding sphere transformed by model; the sphere rejects most objects cheaply,
+    // the box (transformed into a world space box enclosing it) catches the ones the sphere is too loose for
+    bool IntersectsBounds(const glm::vec3 &boxMin, const glm::vec3 &boxMax, const glm::vec3 &sphereCenter, float sphereRadius,
+                          const glm::mat4 &model) const
+    {
+        glm::mat3 linear(model);
+        float scale = glm::sqrt(glm::max(glm::dot(linear[0], linear[0]), glm::max(glm::dot(linear[1], linear[1]), glm::dot(linear[2], linear[2]))));
+        if (!IntersectsSphere(glm::vec3(model * glm::vec4(sphereCenter, 1.0f)), sphereRadius * scale))
+            return false;
+        glm::vec3 center = glm::vec3(model * glm::vec4((boxMin + boxMax) * 0.5f, 1.0f));
+        glm::vec3 extents = (boxMax - boxMin) * 0.5f;
+        glm::vec3 worldExtents = glm::abs(linear[0]) * extents.x + glm::abs(linear[1]) * extents.y + glm::abs(linear[2]) * extents.z;
+        return IntersectsBox(center - worldExtents, center + worldExtents);
+    }
+};
+#endif
@@ -0,0 +1,193 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+// command layout glMultiDrawElementsIndirect reads from the GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// GPU driven instancing (OpenGL 4.3): a compute shader tests every instance's bounding sphere against the frustum,
+// picks a level of detail by its screen space error and appends the instance matrix to that LOD's range of a
+// compacted instance buffer while counting it in the LOD's DrawElementsIndirectCommand. A single
+// glMultiDrawElementsIndirect then draws all LODs without the CPU ever seeing which instances are visible.
+// The LODs are the ranges of the mesh's element buffer in Mesh::lods, drawn from the mesh's own buffers, and the
+// culling shader's storage blocks are expected at these bindings:
+//   0: mat4 instances[]          all instance matrices
+//   1: mat4 visibleInstances[]   compacted output, LOD i starts at commands[i].baseInstance
+//   2: DrawCommand commands[]    one per LOD, instanceCount is counted up with atomicAdd
+// The instance matrices are read by the vertex shader at attribute locations 3 to 6, as in the instancing demo.
+// ------------------------------------------------------------------------------------------------------
+class GPUCuller
+{
+public:
+    static const int MAX_LODS = 8;
+
+    unsigned int VAO;
+    GLenum indexType;
+
+    // draws mesh.lods (at most MAX_LODS of them); the mesh must outlive the culler
+    GPUCuller(const Shader &cullShader, const Mesh &mesh)
+        : indexType(mesh.indexType), cullShader(cullShader), instanceCount(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &instanceBuffer);
+        glGenBuffers(1, &visibleBuffer);
+        glGenBuffers(1, &commandBuffer);
+        setupLods(mesh);
+
+        planeHandles.resize(6);
+        for (int i = 0; i < 6; i++)
+            planeHandles[i] = cullShader.uniformHandle("frustumPlanes[" + std::to_string(i) + "]");
+        for (unsigned int i = 0; i < commands.size(); i++)
+            errorHandles.push_back(cullShader.uniformHandle("lodErrors[" + std::to_string(i) + "]"));
+    }
+    ~GPUCuller()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        unsigned int buffers[] = { instanceBuffer, visibleBuffer, commandBuffer };
+        glDeleteBuffers(3, buffers);
+    }
+
+    unsigned int lodCount() const { return (unsigned int)commands.size(); }
+
+    // uploads the instance matrices; center and radius are the model space bounding sphere shared by all LODs
+    void setInstances(const glm::mat4 *matrices, unsigned int count, const glm::vec3 &center, float radius)
+    {
+        instanceCount = count;
+        boundingSphere = glm::vec4(center, radius);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(glm::mat4), matrices, GL_STATIC_DRAW);
+        // every LOD gets room for all instances, so the shader never has to know how many ended up in the others
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, commands.size() * count * sizeof(glm::mat4), NULL, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        for (unsigned int i = 0; i < commands.size(); i++)
+            commands[i].baseInstance = i * count;
+    }
+
+    // runs the culling shader; the draw commands are ready for Draw() afterwards.
+    // errorScale comes from lodErrorScale() and selects LODs the same way as Mesh::SelectLod
+    void cull(const Frustum &frustum, const glm::vec3 &cameraPosition, float errorScale)
+    {
+        if (commands.empty())
+            return;
+        // reset the instance counts of the commands
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), &commands[0]);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        cullShader.use();
+        for (int i = 0; i < 6; i++)
+            cullShader.setVec4(planeHandles[i], frustum.planes[i]);
+        for (unsigned int i = 0; i < errorHandles.size(); i++)
+            cullShader.setFloat(errorHandles[i], lodErrors[i]);
+        cullShader.setVec4("boundingSphere", boundingSphere);
+        cullShader.setVec3("cameraPosition", cameraPosition);
+        cullShader.setFloat("errorScale", errorScale);
+        cullShader.setInt("lodCount", (int)commands.size());
+        cullShader.setInt("instanceCount", (int)instanceCount);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+        glDispatchCompute((instanceCount + 63) / 64, 1, 1);
+        // the commands are read as indirect draw parameters and the matrices as instanced vertex attributes
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // draws the instances that passed the last cull() with the currently bound shader and textures
+    void Draw()
+    {
+        if (commands.empty())
+            return;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, 0, (GLsizei)commands.size(), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    // reads back the number of visible instances per LOD; stalls until the GPU finished culling, so only for statistics
+    std::vector<unsigned int> visibleCounts()
+    {
+        std::vector<DrawElementsIndirectCommand> result(commands.size());
+        std::vector<unsigned int> counts(commands.size());
+        if (commands.empty())
+            return counts;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, result.size() * sizeof(DrawElementsIndirectCommand), &result[0]);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        for (unsigned int i = 0; i < result.size(); i++)
+            counts[i] = result[i].instanceCount;
+        return counts;
+    }
+
+private:
+    const Shader &cullShader;
+    unsigned int instanceBuffer, visibleBuffer, commandBuffer;
+    unsigned int instanceCount;
+    glm::vec4 boundingSphere;
+    std::vector<float> lodErrors;
+    // template of the draw commands with instanceCount 0, uploaded before every cull()
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<Shader::UniformHandle> planeHandles, errorHandles;
+
+    // creates a draw command per LOD and a VAO reading the mesh's buffers and the compacted instance matrices
+    void setupLods(const Mesh &mesh)
+    {
+        if (mesh.lods.size() > (unsigned int)MAX_LODS)
+            std::cout << "ERROR::GPU_CULLER::Mesh has " << mesh.lods.size() << " LODs, only the first " << MAX_LODS << " are drawn" << std::endl;
+        for (unsigned int i = 0; i < mesh.lods.size() && i < (unsigned int)MAX_LODS; i++)
+        {
+            DrawElementsIndirectCommand command;
+            command.count = mesh.lods[i].indexCount;
+            command.instanceCount = 0;
+            command.firstIndex = mesh.lods[i].firstIndex;
+            command.baseVertex = 0;
+            command.baseInstance = 0;
+            commands.push_back(command);
+            lodErrors.push_back(mesh.lods[i].error);
+        }
+        if (commands.empty())
+            return;
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), &commands[0], GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        Mesh::SetupVertexAttributes(mesh.format);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+        // instance matrices from the compacted buffer, the draw commands' baseInstance selects each LOD's range
+        glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+        for (unsigned int column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(3 + column, 1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    GPUCuller(const GPUCuller&);
+    GPUCuller &operator=(const GPUCuller&);
+};
+#endif
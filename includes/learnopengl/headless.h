@@ -0,0 +1,26 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Headless mode (configure with -DHEADLESS=ON): instead of GLFW the demos link src/headless.cpp, which implements
+// the GLFW calls they use on top of a surfaceless EGL context (or OSMesa when EGL isn't available). The demo renders
+// into an offscreen framebuffer that stands in for the window's default framebuffer, glfwGetTime() advances by a
+// fixed step per frame so every run renders the same images, and glfwWindowShouldClose() ends the loop after a set
+// number of frames. Everything is configured through environment variables:
+//   LOGL_FRAMES       number of frames to render (default 60)
+//   LOGL_TIME_STEP    seconds glfwGetTime() advances per frame (default 1/60)
+//   LOGL_OUTPUT       directory for the captured frames and timing.json (default: the working directory)
+//   LOGL_CAPTURE      comma separated frames to save as frame_NNNN.png, 'all' or 'none' (default: the last frame)
+//   LOGL_REFERENCE    directory with reference frame_NNNN.png images; a captured frame whose mean absolute difference
+//                     to its reference exceeds LOGL_TOLERANCE (in 0-255 units, default 1.0) fails the run
+//   LOGL_CAMERA_PATH  text file of camera keyframes, one 'frame x y z yaw pitch [zoom]' per line, interpolated
+//                     linearly and applied to the demo's Camera before every frame
+//   LOGL_BACKEND      'egl' or 'osmesa' (default: egl, falling back to osmesa if it was built in)
+// timing.json holds the renderer and every frame's time from one swap to the next, glFinish()ed so it includes
+// the GPU's work; reading back captured frames isn't part of it.
+// ------------------------------------------------------------------------------------------------------
+class Camera;
+
+// makes camera follow LOGL_CAMERA_PATH; called by the Camera constructors, the last camera created is the one driven
+void headlessAttachCamera(Camera *camera);
+
+#endif
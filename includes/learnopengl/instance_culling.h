@@ -0,0 +1,239 @@
+#ifndef INSTANCE_CULLING_H
+#define INSTANCE_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+#include <learnopengl/mesh.h>
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INSTANCE_CULLING_SSE
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define INSTANCE_CULLING_AVX2_TARGET
+#else
+// compile the AVX2 kernel for AVX2 regardless of the flags of the rest of the program, it's only called if the CPU supports it
+#define INSTANCE_CULLING_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// Defines the kernels InstanceCuller can test the instances with
+enum Culling_Path {
+    CULL_SCALAR,
+    CULL_SSE,  // 4 instances at a time
+    CULL_AVX2  // 8 instances at a time
+};
+
+// Frustum culling of many instances of one model on the CPU. The instances' world space bounding spheres are
+// kept as a structure of arrays (all x, all y, all z, all radii) so the SIMD kernels test 4 or 8 of them per
+// plane with a handful of instructions. cull() writes the matrices of the visible instances, in their original
+// order, straight to the destination (typically a mapped StreamBuffer) ready to be drawn instanced; cullLods()
+// additionally groups them by the level of detail each instance needs, one instanced draw per LOD.
+// ------------------------------------------------------------------------------------------------------
+class InstanceCuller
+{
+public:
+    // kernel cull() uses, defaults to the fastest one the CPU supports
+    Culling_Path path;
+
+    InstanceCuller() : path(bestPath()), count(0) {}
+
+    // takes a copy of the instance matrices; center and radius are the model space bounding sphere of the model
+    void setInstances(const glm::mat4 *instanceMatrices, unsigned int instanceCount, const glm::vec3 &center, float radius)
+    {
+        count = instanceCount;
+        matrices.assign(instanceMatrices, instanceMatrices + instanceCount);
+        // pad to a multiple of 8 with spheres no frustum can contain, so the kernels need no remainder loop
+        unsigned int padded = (instanceCount + 7) & ~7u;
+        centerX.assign(padded, 0.0f);
+        centerY.assign(padded, 0.0f);
+        centerZ.assign(padded, 0.0f);
+        radii.assign(padded, -1e30f);
+        scales.assign(padded, 0.0f);
+        visibleIndices.resize(padded);
+        for (unsigned int i = 0; i < instanceCount; i++)
+        {
+            const glm::mat4 &model = instanceMatrices[i];
+            glm::vec3 world = glm::vec3(model * glm::vec4(center, 1.0f));
+            float scale = glm::sqrt(glm::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+                                    glm::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2])))));
+            centerX[i] = world.x;
+            centerY[i] = world.y;
+            centerZ[i] = world.z;
+            radii[i] = radius * scale;
+            scales[i] = scale;
+        }
+    }
+
+    unsigned int instanceCount() const { return count; }
+
+    // writes the matrices of all instances inside the frustum to destination, which must have room for instanceCount()
+    // matrices; returns the number of visible instances
+    unsigned int cull(const Frustum &frustum, glm::mat4 *destination) const
+    {
+        unsigned int visible = cullIndices(frustum);
+        for (unsigned int i = 0; i < visible; i++)
+            destination[i] = matrices[visibleIndices[i]];
+        return visible;
+    }
+
+    // like cull(), but sorted by the LOD of mesh each instance needs (see Mesh::SelectLod) so every LOD's instances
+    // are contiguous: LOD i's lodCounts[i] matrices start at destination + lodOffsets[i]. lodCounts and lodOffsets
+    // need room for mesh.lods.size() entries. Returns the number of visible instances.
+    unsigned int cullLods(const Frustum &frustum, const Mesh &mesh, const glm::vec3 &cameraPosition, float errorScale,
+                          glm::mat4 *destination, unsigned int *lodCounts, unsigned int *lodOffsets) const
+    {
+        unsigned int visible = cullIndices(frustum);
+        unsigned int lodCount = (unsigned int)mesh.lods.size();
+        visibleLods.resize(visible);
+        std::fill(lodCounts, lodCounts + lodCount, 0u);
+        for (unsigned int i = 0; i < visible; i++)
+        {
+            unsigned int index = visibleIndices[i];
+            float distance = glm::length(glm::vec3(centerX[index], centerY[index], centerZ[index]) - cameraPosition);
+            visibleLods[i] = mesh.SelectLod(distance, scales[index], errorScale);
+            lodCounts[visibleLods[i]]++;
+        }
+        unsigned int offset = 0;
+        for (unsigned int lod = 0; lod < lodCount; lod++)
+        {
+            lodOffsets[lod] = offset;
+            offset += lodCounts[lod];
+        }
+        lodCursors.assign(lodOffsets, lodOffsets + lodCount);
+        for (unsigned int i = 0; i < visible; i++)
+            destination[lodCursors[visibleLods[i]]++] = matrices[visibleIndices[i]];
+        return visible;
+    }
+
+    static bool supported(Culling_Path path)
+    {
+        if (path == CULL_SCALAR)
+            return true;
+#ifdef INSTANCE_CULLING_SSE
+        if (path == CULL_SSE)
+            return true;
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+#else
+        return false;
+#endif
+    }
+
+    static Culling_Path bestPath()
+    {
+        return supported(CULL_AVX2) ? CULL_AVX2 : supported(CULL_SSE) ? CULL_SSE : CULL_SCALAR;
+    }
+
+private:
+    std::vector<glm::mat4> matrices;
+    std::vector<float> centerX, centerY, centerZ, radii, scales;
+    unsigned int count;
+    // scratch of the last cull: indices of the visible instances and their LODs
+    mutable std::vector<unsigned int> visibleIndices;
+    mutable std::vector<unsigned int> visibleLods;
+    mutable std::vector<unsigned int> lodCursors;
+
+    // stores the indices of the instances inside the frustum in visibleIndices with the selected kernel, returns their number
+    unsigned int cullIndices(const Frustum &frustum) const
+    {
+        unsigned int *destination = visibleIndices.empty() ? NULL : &visibleIndices[0];
+#ifdef INSTANCE_CULLING_SSE
+        if (path == CULL_AVX2 && supported(CULL_AVX2))
+            return cullAVX2(frustum, destination);
+        if (path != CULL_SCALAR)
+            return cullSSE(frustum, destination);
+#endif
+        return cullScalar(frustum, destination);
+    }
+
+    unsigned int cullScalar(const Frustum &frustum, unsigned int *destination) const
+    {
+        unsigned int visible = 0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; p++)
+            {
+                const glm::vec4 &plane = frustum.planes[p];
+                inside = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w >= -radii[i];
+            }
+            if (inside)
+                destination[visible++] = i;
+        }
+        return visible;
+    }
+
+#ifdef INSTANCE_CULLING_SSE
+    unsigned int cullSSE(const Frustum &frustum, unsigned int *destination) const
+    {
+        __m128 planes[6][4];
+        for (int p = 0; p < 6; p++)
+            for (int k = 0; k < 4; k++)
+                planes[p][k] = _mm_set1_ps(frustum.planes[p][k]);
+        const __m128 zero = _mm_setzero_ps();
+        unsigned int visible = 0;
+        for (unsigned int i = 0; i < count; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&centerX[i]);
+            __m128 y = _mm_loadu_ps(&centerY[i]);
+            __m128 z = _mm_loadu_ps(&centerZ[i]);
+            __m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(&radii[i]));
+            __m128 inside = _mm_cmpeq_ps(zero, zero);
+            for (int p = 0; p < 6; p++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], x), _mm_mul_ps(planes[p][1], y)),
+                                             _mm_add_ps(_mm_mul_ps(planes[p][2], z), planes[p][3]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; mask != 0; lane++, mask >>= 1)
+                if (mask & 1)
+                    destination[visible++] = i + lane;
+        }
+        return visible;
+    }
+
+    INSTANCE_CULLING_AVX2_TARGET unsigned int cullAVX2(const Frustum &frustum, unsigned int *destination) const
+    {
+        __m256 planes[6][4];
+        for (int p = 0; p < 6; p++)
+            for (int k = 0; k < 4; k++)
+                planes[p][k] = _mm256_set1_ps(frustum.planes[p][k]);
+        const __m256 zero = _mm256_setzero_ps();
+        unsigned int visible = 0;
+        for (unsigned int i = 0; i < count; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(&centerX[i]);
+            __m256 y = _mm256_loadu_ps(&centerY[i]);
+            __m256 z = _mm256_loadu_ps(&centerZ[i]);
+            __m256 negativeRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(&radii[i]));
+            __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+            for (int p = 0; p < 6; p++)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planes[p][0], x), _mm256_mul_ps(planes[p][1], y)),
+                                                _mm256_add_ps(_mm256_mul_ps(planes[p][2], z), planes[p][3]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+            int mask = _mm256_movemask_ps(inside);
+            for (int lane = 0; mask != 0; lane++, mask >>= 1)
+                if (mask & 1)
+                    destination[visible++] = i + lane;
+        }
+        return visible;
+    }
+#endif
+};
+#endif
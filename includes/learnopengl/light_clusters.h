@@ -0,0 +1,260 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// point light with the attenuation 1 / (1 + linear * d + quadratic * d^2), ignored beyond radius
+struct PointLight
+{
+    glm::vec3 Position;
+    glm::vec3 Color;
+    float Linear;
+    float Quadratic;
+    float Radius;
+};
+
+// Clustered light culling: the view frustum is cut into a grid of froxels (gridX by gridY screen tiles and gridZ depth
+// slices spaced exponentially between the near and far plane) and every froxel gets the list of lights whose sphere
+// touches it. The lighting shader looks up the froxel of its fragment and only shades with the lights in its list, so
+// the cost per pixel follows the number of lights nearby instead of the number of lights in the scene.
+// The lists are built on the CPU and handed to the shader in three buffer textures (OpenGL 3.3 has no storage buffers):
+//     lightData     RGBA32F, three texels per light: (position, radius), (color, linear), (quadratic, 0, 0, 0)
+//     clusterRanges RG32UI, per froxel the offset and count of its lights in lightIndices
+//     lightIndices  R32UI, the light indices of all froxels one after the other
+// bind() sets these along with the uniforms the shader needs to find a fragment's froxel:
+//     uvec3 clusterGrid; vec2 clusterTileSize; float clusterSliceScale, clusterSliceBias; mat4 clusterView
+// where the froxel of a fragment at view depth z (positive) is
+//     uvec3(gl_FragCoord.xy / clusterTileSize, log(z) * clusterSliceScale + clusterSliceBias)
+// ------------------------------------------------------------------------------------------------------
+class LightClusters
+{
+public:
+    unsigned int gridX, gridY, gridZ;
+    // light references in the froxel lists and the most lights in a single froxel, of the last update()
+    unsigned int lightReferences;
+    unsigned int maxLightsPerCluster;
+
+    LightClusters(unsigned int gridX = 16, unsigned int gridY = 9, unsigned int gridZ = 24)
+        : gridX(gridX), gridY(gridY), gridZ(gridZ), lightReferences(0), maxLightsPerCluster(0), nearPlane(0.1f), farPlane(100.0f),
+          screenWidth(1), screenHeight(1)
+    {
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            glGenBuffers(1, &buffers[i]);
+            glGenTextures(1, &textures[i]);
+        }
+        ranges.resize(gridX * gridY * gridZ * 2);
+    }
+    ~LightClusters()
+    {
+        glDeleteBuffers(3, buffers);
+        glDeleteTextures(3, textures);
+    }
+
+    // the projection the froxels subdivide; call again whenever it or the screen size changes
+    void setProjection(float fovY, float aspect, float nearPlane, float farPlane, unsigned int screenWidth, unsigned int screenHeight)
+    {
+        this->nearPlane = nearPlane;
+        this->farPlane = farPlane;
+        this->screenWidth = screenWidth;
+        this->screenHeight = screenHeight;
+        tanHalfFovY = std::tan(fovY * 0.5f);
+        tanHalfFovX = tanHalfFovY * aspect;
+        // view space bounds of every froxel
+        clusterMin.resize(gridX * gridY * gridZ);
+        clusterMax.resize(gridX * gridY * gridZ);
+        for (unsigned int z = 0; z < gridZ; z++)
+        {
+            float depths[2] = { sliceDepth(z), sliceDepth(z + 1) };
+            for (unsigned int y = 0; y < gridY; y++)
+            {
+                for (unsigned int x = 0; x < gridX; x++)
+                {
+                    glm::vec3 low(1e30f), high(-1e30f);
+                    for (unsigned int corner = 0; corner < 8; corner++)
+                    {
+                        float ndcX = ((x + (corner & 1)) / (float)gridX) * 2.0f - 1.0f;
+                        float ndcY = ((y + (corner >> 1 & 1)) / (float)gridY) * 2.0f - 1.0f;
+                        float depth = depths[corner >> 2];
+                        glm::vec3 point(ndcX * depth * tanHalfFovX, ndcY * depth * tanHalfFovY, -depth);
+                        low = glm::min(low, point);
+                        high = glm::max(high, point);
+                    }
+                    clusterMin[clusterIndex(x, y, z)] = low;
+                    clusterMax[clusterIndex(x, y, z)] = high;
+                }
+            }
+        }
+    }
+
+    // rebuilds the froxel lists for the camera's view matrix and uploads them along with the lights
+    void update(const glm::mat4 &view, const std::vector<PointLight> &lights)
+    {
+        this->view = view;
+        // every froxel each light touches, as (froxel, light) pairs
+        pairs.clear();
+        for (unsigned int i = 0; i < lights.size(); i++)
+            assign(glm::vec3(view * glm::vec4(lights[i].Position, 1.0f)), lights[i].Radius, i);
+
+        // counting sort of the pairs by froxel gives every froxel a contiguous range of light indices
+        const unsigned int clusterCount = gridX * gridY * gridZ;
+        std::fill(ranges.begin(), ranges.end(), 0u);
+        for (unsigned int i = 0; i < pairs.size(); i++)
+            ranges[pairs[i].cluster * 2 + 1]++;
+        unsigned int offset = 0;
+        maxLightsPerCluster = 0;
+        for (unsigned int cluster = 0; cluster < clusterCount; cluster++)
+        {
+            ranges[cluster * 2] = offset;
+            offset += ranges[cluster * 2 + 1];
+            maxLightsPerCluster = std::max(maxLightsPerCluster, ranges[cluster * 2 + 1]);
+        }
+        lightReferences = offset;
+        indices.resize(std::max(offset, 1u));
+        fill.assign(ranges.begin(), ranges.end());
+        for (unsigned int i = 0; i < pairs.size(); i++)
+            indices[fill[pairs[i].cluster * 2]++] = pairs[i].light;
+
+        lightData.resize(std::max((size_t)lights.size(), (size_t)1) * 12);
+        for (unsigned int i = 0; i < lights.size(); i++)
+        {
+            float *texels = &lightData[i * 12];
+            texels[0] = lights[i].Position.x; texels[1] = lights[i].Position.y; texels[2] = lights[i].Position.z; texels[3] = lights[i].Radius;
+            texels[4] = lights[i].Color.r; texels[5] = lights[i].Color.g; texels[6] = lights[i].Color.b; texels[7] = lights[i].Linear;
+            texels[8] = lights[i].Quadratic; texels[9] = texels[10] = texels[11] = 0.0f;
+        }
+
+        upload(0, GL_RGBA32F, &lightData[0], lightData.size() * sizeof(float));
+        upload(1, GL_RG32UI, &ranges[0], ranges.size() * sizeof(unsigned int));
+        upload(2, GL_R32UI, &indices[0], indices.size() * sizeof(unsigned int));
+    }
+
+    // binds the three buffer textures to units firstUnit to firstUnit + 2 and sets the shader's cluster uniforms;
+    // the shader must be in use
+    void bind(const Shader &shader, unsigned int firstUnit)
+    {
+        const char *samplers[3] = { "lightData", "clusterRanges", "lightIndices" };
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            shader.setInt(samplers[i], firstUnit + i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        shader.setUVec3("clusterGrid", glm::uvec3(gridX, gridY, gridZ));
+        shader.setVec2("clusterTileSize", glm::vec2((float)screenWidth / gridX, (float)screenHeight / gridY));
+        float logRange = std::log(farPlane / nearPlane);
+        shader.setFloat("clusterSliceScale", gridZ / logRange);
+        shader.setFloat("clusterSliceBias", -(float)gridZ * std::log(nearPlane) / logRange);
+        shader.setMat4("clusterView", view);
+    }
+
+private:
+    struct Pair
+    {
+        unsigned int cluster;
+        unsigned int light;
+    };
+
+    float nearPlane, farPlane, tanHalfFovX, tanHalfFovY;
+    unsigned int screenWidth, screenHeight;
+    glm::mat4 view;
+    std::vector<glm::vec3> clusterMin, clusterMax;
+    std::vector<Pair> pairs;
+    std::vector<unsigned int> ranges, fill, indices;
+    std::vector<float> lightData;
+    unsigned int buffers[3], textures[3];
+
+    unsigned int clusterIndex(unsigned int x, unsigned int y, unsigned int z) const
+    {
+        return x + gridX * (y + gridY * z);
+    }
+
+    // view depth where slice z starts
+    float sliceDepth(unsigned int z) const
+    {
+        return nearPlane * std::pow(farPlane / nearPlane, (float)z / gridZ);
+    }
+    int sliceOf(float depth) const
+    {
+        return (int)std::floor(std::log(depth / nearPlane) / std::log(farPlane / nearPlane) * gridZ);
+    }
+
+    // adds the light at view space center to every froxel its sphere touches
+    void assign(const glm::vec3 &center, float radius, unsigned int light)
+    {
+        float nearest = -center.z - radius, furthest = -center.z + radius;
+        if (furthest < nearPlane || nearest > farPlane)
+            return;
+        nearest = std::max(nearest, nearPlane);
+        furthest = std::min(furthest, farPlane);
+        int firstSlice = std::max(sliceOf(nearest), 0), lastSlice = std::min(sliceOf(furthest), (int)gridZ - 1);
+
+        // tiles covered by the sphere's view space box: x / depth is monotonic in depth, so its extremes lie at the
+        // nearest or furthest depth of the box
+        float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f;
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            float depth = i == 0 ? nearest : furthest;
+            for (unsigned int side = 0; side < 2; side++)
+            {
+                float offset = side == 0 ? -radius : radius;
+                float ndcX = (center.x + offset) / (depth * tanHalfFovX);
+                float ndcY = (center.y + offset) / (depth * tanHalfFovY);
+                minX = std::min(minX, ndcX); maxX = std::max(maxX, ndcX);
+                minY = std::min(minY, ndcY); maxY = std::max(maxY, ndcY);
+            }
+        }
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+            return;
+        int firstX = tile(minX, gridX), lastX = tile(maxX, gridX);
+        int firstY = tile(minY, gridY), lastY = tile(maxY, gridY);
+
+        float radiusSquared = radius * radius;
+        for (int z = firstSlice; z <= lastSlice; z++)
+        {
+            for (int y = firstY; y <= lastY; y++)
+            {
+                for (int x = firstX; x <= lastX; x++)
+                {
+                    unsigned int cluster = clusterIndex(x, y, z);
+                    // distance from the sphere's center to the froxel's box
+                    glm::vec3 closest = glm::clamp(center, clusterMin[cluster], clusterMax[cluster]);
+                    glm::vec3 offset = closest - center;
+                    if (glm::dot(offset, offset) <= radiusSquared)
+                    {
+                        Pair pair = { cluster, light };
+                        pairs.push_back(pair);
+                    }
+                }
+            }
+        }
+    }
+
+    static int tile(float ndc, unsigned int tiles)
+    {
+        int index = (int)std::floor((ndc * 0.5f + 0.5f) * tiles);
+        return std::min(std::max(index, 0), (int)tiles - 1);
+    }
+
+    void upload(unsigned int i, GLenum format, const void *data, size_t bytes)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, bytes, data, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffers[i]);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    LightClusters(const LightClusters&);
+    LightClusters &operator=(const LightClusters&);
+};
+#endif
@@ -0,0 +1,178 @@
+#ifndef LIGHT_VOLUMES_H
+#define LIGHT_VOLUMES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/light_clusters.h>
+
+#include <vector>
+#include <cmath>
+
+// Deferred lighting with light volumes: instead of a full screen quad that tests every light at every pixel, each
+// light draws a sphere of its radius and only the pixels the sphere covers run its lighting, blended additively into
+// the bound framebuffer. All lights go out in two instanced draws:
+//  1. stencil pass: the front and back faces of every sphere are drawn without color, counting in the stencil buffer
+//     the spheres whose back face lies behind the scene (+1) minus those whose front face does too (-1), which leaves
+//     the number of spheres each visible surface point is inside of. Surfaces in front of or behind all spheres stay 0.
+//  2. lighting pass: the back faces are drawn where the stencil isn't 0 and the scene's depth is in front of them, so
+//     a light skips the pixels whose surface is behind its sphere and the pixels no light reaches at all.
+// The bound framebuffer needs the scene's depth (e.g. the G-buffer's depth renderbuffer) with a stencil buffer; the
+// stencil buffer is cleared here. The shaders get the sphere's vertices at location 0 and the light, packed like
+// LightClusters' lightData, at locations 1 (position, radius), 2 (color, linear) and 3 (quadratic), one per instance,
+// and the camera from the FrameData block (see frame_data.h); the lighting shader reads the G-buffer at gl_FragCoord
+// and shades with that one light.
+// ------------------------------------------------------------------------------------------------------
+class LightVolumes
+{
+public:
+    LightVolumes(const Shader &stencilShader, const Shader &lightShader)
+        : stencilShader(stencilShader), lightShader(lightShader), sphereVAO(0), sphereVBO(0), sphereEBO(0), instanceVBO(0), indexCount(0),
+          instanceCapacity(0), lightCount(0)
+    {
+        createSphere(16, 12);
+    }
+    ~LightVolumes()
+    {
+        glDeleteVertexArrays(1, &sphereVAO);
+        glDeleteBuffers(1, &sphereVBO);
+        glDeleteBuffers(1, &sphereEBO);
+        glDeleteBuffers(1, &instanceVBO);
+    }
+
+    // uploads the lights the next draw() renders
+    void update(const std::vector<PointLight> &lights)
+    {
+        instances.resize(lights.size() * 9);
+        for (unsigned int i = 0; i < lights.size(); i++)
+        {
+            float *instance = &instances[i * 9];
+            instance[0] = lights[i].Position.x; instance[1] = lights[i].Position.y; instance[2] = lights[i].Position.z; instance[3] = lights[i].Radius;
+            instance[4] = lights[i].Color.r; instance[5] = lights[i].Color.g; instance[6] = lights[i].Color.b; instance[7] = lights[i].Linear;
+            instance[8] = lights[i].Quadratic;
+        }
+        lightCount = (unsigned int)lights.size();
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        // orphan the old storage when it's big enough instead of waiting for the GPU to finish with it
+        if (lightCount > instanceCapacity)
+            instanceCapacity = lightCount;
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * 9 * sizeof(float), NULL, GL_STREAM_DRAW);
+        if (lightCount > 0)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(float), &instances[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // adds the lighting of every light to the bound framebuffer, seen from the camera of the last FrameData update.
+    // Leaves depth testing enabled with writes on and GL_LESS, blending, stencil testing and face culling disabled.
+    void draw()
+    {
+        if (lightCount == 0)
+            return;
+        glBindVertexArray(sphereVAO);
+
+        // 1. stencil pass
+        glClear(GL_STENCIL_BUFFER_BIT);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_FALSE);
+        glDisable(GL_CULL_FACE);
+        glEnable(GL_STENCIL_TEST);
+        glStencilMask(0xFF);
+        glStencilFunc(GL_ALWAYS, 0, 0xFF);
+        glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+        glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        stencilShader.use();
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, lightCount);
+
+        // 2. lighting pass
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        glDepthFunc(GL_GEQUAL);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        lightShader.use();
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, lightCount);
+
+        glDisable(GL_BLEND);
+        glCullFace(GL_BACK);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_STENCIL_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glBindVertexArray(0);
+    }
+
+private:
+    const Shader &stencilShader;
+    const Shader &lightShader;
+    unsigned int sphereVAO, sphereVBO, sphereEBO, instanceVBO;
+    unsigned int indexCount;
+    unsigned int instanceCapacity, lightCount;
+    std::vector<float> instances;
+
+    // unit sphere of segments by rings quads, pushed out so its flat faces enclose the round sphere instead of
+    // cutting into it
+    void createSphere(unsigned int segments, unsigned int rings)
+    {
+        const float PI = 3.14159265359f;
+        const float scale = 1.0f / (std::cos(PI / segments) * std::cos(PI / (2.0f * rings)));
+        std::vector<float> positions;
+        std::vector<unsigned int> indices;
+        for (unsigned int y = 0; y <= rings; y++)
+        {
+            float theta = (float)y / rings * PI;
+            for (unsigned int x = 0; x <= segments; x++)
+            {
+                float phi = (float)x / segments * 2.0f * PI;
+                positions.push_back(std::cos(phi) * std::sin(theta) * scale);
+                positions.push_back(std::cos(theta) * scale);
+                positions.push_back(std::sin(phi) * std::sin(theta) * scale);
+            }
+        }
+        // counter clockwise seen from outside
+        for (unsigned int y = 0; y < rings; y++)
+        {
+            for (unsigned int x = 0; x < segments; x++)
+            {
+                unsigned int i0 = y * (segments + 1) + x, i1 = i0 + 1, i2 = i0 + segments + 1, i3 = i2 + 1;
+                indices.push_back(i0); indices.push_back(i1); indices.push_back(i2);
+                indices.push_back(i1); indices.push_back(i3); indices.push_back(i2);
+            }
+        }
+        indexCount = (unsigned int)indices.size();
+
+        glGenVertexArrays(1, &sphereVAO);
+        glGenBuffers(1, &sphereVBO);
+        glGenBuffers(1, &sphereEBO);
+        glGenBuffers(1, &instanceVBO);
+        glBindVertexArray(sphereVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), &positions[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        // per instance light
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(8 * sizeof(float)));
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribDivisor(2, 1);
+        glVertexAttribDivisor(3, 1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    LightVolumes(const LightVolumes&);
+    LightVolumes &operator=(const LightVolumes&);
+};
+#endif
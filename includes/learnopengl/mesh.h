@@ -5,6 +5,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <learnopengl/shader.h>
 
@@ -28,6 +29,53 @@ struct Vertex {
     glm::vec3 Bitangent;
 };
 
+// Compact 24 byte alternative to Vertex for meshes that are bound by vertex fetch bandwidth:
+// the normal and tangent are packed as signed normalized 10:10:10:2 and the texture coordinates as half floats.
+// There is no bitangent, the tangent's w holds the handedness so shaders reconstruct it with
+//     vec3 bitangent = cross(normal, tangent.xyz) * tangent.w;
+// as the PACKED_TANGENT variant of 4.normal_mapping.vs does.
+// The attribute locations stay the same as for Vertex (0 position, 1 normal, 2 texCoords, 3 tangent as vec4).
+struct PackedVertex {
+    glm::vec3 Position;
+    glm::uint32 Normal;
+    glm::uint32 Tangent;
+    glm::uint16 TexCoords[2];
+};
+
+// vertex layout a mesh uploads to the GPU
+enum Vertex_Format {
+    FULL_VERTEX,
+    PACKED_VERTEX
+};
+
+inline PackedVertex packVertex(const Vertex &vertex)
+{
+    PackedVertex packed;
+    packed.Position = vertex.Position;
+    packed.Normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.Normal, 0.0f));
+    // handedness of the tangent frame, the bitangent is rebuilt as cross(N, T) * w
+    float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+    packed.Tangent = glm::packSnorm3x10_1x2(glm::vec4(vertex.Tangent, handedness));
+    packed.TexCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+    packed.TexCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+    return packed;
+}
+
+// level of detail of a mesh: a range of its element buffer that draws a simplified version of it with the same
+// vertices. error is the largest distance (in model space) the simplification moved the surface.
+struct MeshLod {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    float error;
+};
+
+// scale from a model space error at distance 1 to the fraction of pixelThreshold it covers on screen;
+// a LOD is detailed enough while error * instanceScale * lodErrorScale(...) <= distance
+inline float lodErrorScale(float fovY, float viewportHeight, float pixelThreshold)
+{
+    return viewportHeight / (2.0f * glm::tan(fovY * 0.5f)) / pixelThreshold;
+}
+
 struct Texture {
     unsigned int id;
     string type;
@@ -41,64 +89,226 @@ public:
     vector<unsigned int> indices;
     vector<Texture> textures;
     unsigned int VAO;
+    // number of vertices in the GPU buffers and indices of lod 0. Meshes restored from the model cache are uploaded
+    // straight from the mapped cache file and keep no CPU-side copy in vertices/indices.
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    // levels of detail from most to least detailed, all in the one element buffer; lods[0] is the full mesh
+    vector<MeshLod> lods;
+    // axis aligned bounding box in model space
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    // bounding sphere in model space, centered on the box
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+    // layout of the vertex buffer
+    Vertex_Format format;
+    // type of the element buffer's indices: GL_UNSIGNED_SHORT whenever every index fits in 16 bits, else GL_UNSIGNED_INT.
+    // pass it to any draw call that uses the mesh's VAO directly (e.g. instanced draws).
+    GLenum indexType;
+
+    // vertex and element buffer behind the VAO, e.g. to copy the mesh into a combined buffer
+    unsigned int VBO, EBO;
 
     /*  Functions  */
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor; indices holds the index lists of all lods back to back, no lods means a single lod of all indices
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, Vertex_Format format = FULL_VERTEX,
+         vector<MeshLod> lods = vector<MeshLod>())
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->format = format;
+        this->vertices.swap(vertices);
+        this->indices.swap(indices);
+        this->textures.swap(textures);
+        vertexCount = this->vertices.size();
+        setupLods(lods, this->indices.size());
+        computeBounds();
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), this->indices.data());
+        setupSamplers();
+    }
+    // constructor for vertex/index data owned by someone else (e.g. a mapped model cache); the data is only read during construction
+    Mesh(const Vertex *vertexData, unsigned int vertexCount, const unsigned int *indexData, unsigned int indexCount, vector<Texture> textures,
+         const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, Vertex_Format format = FULL_VERTEX, vector<MeshLod> lods = vector<MeshLod>())
+    {
+        this->format = format;
+        this->textures.swap(textures);
+        this->vertexCount = vertexCount;
+        setupLods(lods, indexCount);
+        this->boundsMin = boundsMin;
+        this->boundsMax = boundsMax;
+        computeBoundingSphere(vertexData);
+
+        setupMesh(vertexData, indexData);
+        setupSamplers();
+    }
+
+    // size of one vertex in the vertex buffer
+    static GLsizei VertexSize(Vertex_Format format)
+    {
+        return format == PACKED_VERTEX ? sizeof(PackedVertex) : sizeof(Vertex);
+    }
+
+    // sets the attribute pointers of the bound VAO for vertices of the given format in the buffer bound to GL_ARRAY_BUFFER
+    static void SetupVertexAttributes(Vertex_Format format)
+    {
+        if(format == PACKED_VERTEX)
+        {
+            // vertex Positions
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)0);
+            // vertex normals, normalized from [-511, 511] to [-1, 1]
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+            // vertex texture coords
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+            // vertex tangent + handedness
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Tangent));
+            return;
+        }
+        // set the vertex attribute pointers
+        // vertex Positions
+        glEnableVertexAttribArray(0);	
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        // vertex normals
+        glEnableVertexAttribArray(1);	
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);	
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        // vertex tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+        // vertex bitangent
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+    }
+
+    // byte offset of a lod's first index in the element buffer, for draw calls that use the VAO directly
+    const void *IndexOffset(unsigned int lod) const
+    {
+        return (const void*)((size_t)lods[lod].firstIndex * (indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int)));
+    }
+
+    // least detailed lod whose error stays below the pixel threshold for an instance scaled by scale at the given
+    // distance from the camera; errorScale comes from lodErrorScale()
+    unsigned int SelectLod(float distance, float scale, float errorScale) const
+    {
+        unsigned int lod = 0;
+        while(lod + 1 < lods.size() && lods[lod + 1].error * scale * errorScale <= distance)
+            lod++;
+        return lod;
     }
 
     // render the mesh
-    void Draw(Shader shader) 
+    void Draw(const Shader &shader, unsigned int lod = 0) 
+    {
+        // bind appropriate textures, the sampler uniforms were resolved the first time this shader drew the mesh
+        RenderState &state = RenderState::shared();
+        const vector<Shader::UniformHandle> &samplers = samplerHandles(shader);
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            // set the sampler to the correct texture unit (skipped by the shader if it already is)
+            shader.setInt(samplers[i], i);
+            // and bind the texture, the unit is only made active if the texture isn't bound to it yet
+            state.bindTexture(i, GL_TEXTURE_2D, textures[i].id);
+        }
+        
+        // draw mesh; the vertex array stays bound so the next draw of this mesh doesn't rebind it
+        state.bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, lods[lod].indexCount, indexType, IndexOffset(lod));
+
+        // demos bind their own textures right after drawing a model and expect unit 0 to be active
+        state.activeTexture(GL_TEXTURE0);
+    }
+
+private:
+    // indices of all lods in the element buffer
+    unsigned int elementCount;
+    // sampler uniform name of each texture (e.g. texture_diffuse1), texture i is bound to unit i
+    vector<string> samplerNames;
+    // sampler handles per shader program (keyed by program ID); a mesh is rarely drawn with more than a few shaders
+    vector<pair<unsigned int, vector<Shader::UniformHandle> > > samplerBindings;
+
+    /*  Functions    */
+    void setupLods(vector<MeshLod> &lods, unsigned int totalIndexCount)
+    {
+        if(lods.empty())
+        {
+            MeshLod all = { 0, totalIndexCount, 0.0f };
+            lods.push_back(all);
+        }
+        this->lods.swap(lods);
+        indexCount = this->lods[0].indexCount;
+        elementCount = totalIndexCount;
+    }
+
+    void computeBounds()
+    {
+        boundsMin = boundsMax = vertices.empty() ? glm::vec3(0.0f) : vertices[0].Position;
+        for(unsigned int i = 1; i < vertices.size(); i++)
+        {
+            boundsMin = glm::min(boundsMin, vertices[i].Position);
+            boundsMax = glm::max(boundsMax, vertices[i].Position);
+        }
+        computeBoundingSphere(vertices.data());
+    }
+
+    // sphere around the center of the bounding box, tighter than the box's half diagonal for most meshes
+    void computeBoundingSphere(const Vertex *vertexData)
+    {
+        boundsCenter = (boundsMin + boundsMax) * 0.5f;
+        float radiusSquared = 0.0f;
+        for(unsigned int i = 0; i < vertexCount; i++)
+        {
+            glm::vec3 offset = vertexData[i].Position - boundsCenter;
+            radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+        }
+        boundsRadius = glm::sqrt(radiusSquared);
+    }
+
+    // assigns every texture its sampler name following the texture_typeN convention
+    void setupSamplers()
     {
-        // bind appropriate textures
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
+        samplerNames.clear();
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
             if(name == "texture_diffuse")
-				number = std::to_string(diffuseNr++);
-			else if(name == "texture_specular")
-				number = std::to_string(specularNr++); // transfer unsigned int to stream
+                number = std::to_string(diffuseNr++);
+            else if(name == "texture_specular")
+                number = std::to_string(specularNr++);
             else if(name == "texture_normal")
-				number = std::to_string(normalNr++); // transfer unsigned int to stream
-             else if(name == "texture_height")
-			    number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-													 // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+                number = std::to_string(normalNr++);
+            else if(name == "texture_height")
+                number = std::to_string(heightNr++);
+            samplerNames.push_back(name + number);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    /*  Render data  */
-    unsigned int VBO, EBO;
+    // returns the sampler handles of this mesh for the given shader, resolving them on first use
+    const vector<Shader::UniformHandle> &samplerHandles(const Shader &shader)
+    {
+        for(unsigned int i = 0; i < samplerBindings.size(); i++)
+            if(samplerBindings[i].first == shader.ID)
+                return samplerBindings[i].second;
+        vector<Shader::UniformHandle> handles;
+        for(unsigned int i = 0; i < samplerNames.size(); i++)
+            handles.push_back(shader.uniformHandle(samplerNames[i]));
+        samplerBindings.push_back(make_pair(shader.ID, handles));
+        return samplerBindings.back().second;
+    }
 
-    /*  Functions    */
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const Vertex *vertexData, const unsigned int *indexData)
     {
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
@@ -108,32 +318,41 @@ private:
         glBindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        if(format == PACKED_VERTEX)
+            uploadPackedVertices(vertexData);
+        else
+            uploadVertices(vertexData);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        // the indices stay 32 bit on the CPU, small meshes are narrowed to halve the element buffer
+        indexType = vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        if(indexType == GL_UNSIGNED_SHORT)
+        {
+            vector<unsigned short> shortIndices(indexData, indexData + elementCount);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementCount * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+        }
+        else
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
 
         glBindVertexArray(0);
     }
+
+    void uploadVertices(const Vertex *vertexData)
+    {
+        // A great thing about structs is that their memory layout is sequential for all its items.
+        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+        // again translates to 3/2 floats which translates to a byte array.
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertexData, GL_STATIC_DRAW);  
+        SetupVertexAttributes(FULL_VERTEX);
+    }
+
+    void uploadPackedVertices(const Vertex *vertexData)
+    {
+        vector<PackedVertex> packed(vertexCount);
+        for(unsigned int i = 0; i < vertexCount; i++)
+            packed[i] = packVertex(vertexData[i]);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
+        SetupVertexAttributes(PACKED_VERTEX);
+    }
 };
 #endif
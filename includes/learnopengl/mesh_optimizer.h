@@ -0,0 +1,385 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+// CPU-side optimization of indexed triangle lists, run on freshly imported meshes before they are uploaded:
+//   weldVertices()        merges bitwise identical vertices
+//   optimizeVertexCache() reorders triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm)
+//   optimizeOverdraw()    splits the result into clusters and draws outward facing clusters first
+//   optimizeVertexFetch() renumbers vertices in the order they're first used so the vertex buffer is read linearly
+// analyzeVertexCache() simulates a FIFO vertex cache to report the average cache miss ratio (ACMR, transformed
+// vertices per triangle, lower bound 0.5) and the average transform to vertex ratio (ATVR, lower bound 1.0).
+// ------------------------------------------------------------------------------------------------------
+
+// vertex cache statistics; add() accumulates them over several meshes
+struct VertexCacheStats
+{
+    unsigned int triangles;
+    unsigned int vertices;
+    unsigned int transforms; // vertex shader invocations, i.e. cache misses
+
+    VertexCacheStats() : triangles(0), vertices(0), transforms(0) {}
+
+    float acmr() const { return triangles > 0 ? (float)transforms / triangles : 0.0f; }
+    float atvr() const { return vertices > 0 ? (float)transforms / vertices : 0.0f; }
+    void add(const VertexCacheStats &other)
+    {
+        triangles += other.triangles;
+        vertices += other.vertices;
+        transforms += other.transforms;
+    }
+};
+
+// simulates a FIFO post-transform cache of cacheSize entries, which is what most GPUs behave closest to
+inline VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, unsigned int vertexCount, unsigned int cacheSize = 16)
+{
+    VertexCacheStats stats;
+    stats.triangles = (unsigned int)(indices.size() / 3);
+    stats.vertices = vertexCount;
+    // timestamp of the moment a vertex entered the cache; it's still cached while fewer than cacheSize misses happened since
+    std::vector<unsigned int> cachedAt(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        unsigned int vertex = indices[i];
+        if (time - cachedAt[vertex] > cacheSize)
+        {
+            cachedAt[vertex] = time++;
+            stats.transforms++;
+        }
+    }
+    return stats;
+}
+
+// merges vertices whose attributes are bitwise identical and rewrites the indices to match; returns the new vertex count
+inline unsigned int weldVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    struct VertexHash
+    {
+        const std::vector<Vertex> *vertices;
+        size_t operator()(unsigned int index) const
+        {
+            // FNV-1a over the raw vertex bytes
+            const unsigned char *bytes = (const unsigned char*)&(*vertices)[index];
+            size_t hash = 2166136261u;
+            for (size_t i = 0; i < sizeof(Vertex); i++)
+                hash = (hash ^ bytes[i]) * 16777619u;
+            return hash;
+        }
+    };
+    struct VertexEqual
+    {
+        const std::vector<Vertex> *vertices;
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            return std::memcmp(&(*vertices)[a], &(*vertices)[b], sizeof(Vertex)) == 0;
+        }
+    };
+    VertexHash hash = { &vertices };
+    VertexEqual equal = { &vertices };
+    std::unordered_map<unsigned int, unsigned int, VertexHash, VertexEqual> unique(vertices.size(), hash, equal);
+
+    std::vector<unsigned int> remap(vertices.size());
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < vertices.size(); i++)
+    {
+        std::pair<std::unordered_map<unsigned int, unsigned int, VertexHash, VertexEqual>::iterator, bool> inserted = unique.insert(std::make_pair(i, count));
+        if (inserted.second)
+            remap[i] = count++;
+        else
+            remap[i] = inserted.first->second;
+    }
+    // compact in place, a vertex only ever moves towards the front
+    for (unsigned int i = 0; i < vertices.size(); i++)
+        vertices[remap[i]] = vertices[i];
+    vertices.resize(count);
+    for (size_t i = 0; i < indices.size(); i++)
+        indices[i] = remap[indices[i]];
+    return count;
+}
+
+// Forsyth's "Linear-Speed Vertex Cache Optimisation": greedily emits the triangle with the highest score, where vertices
+// score higher the more recently they were used (simulated LRU cache) and the fewer unemitted triangles they have left.
+inline void optimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount)
+{
+    const int cacheSize = 32;
+    const float cacheDecayPower = 1.5f;
+    const float lastTriangleScore = 0.75f;
+    const float valenceBoostScale = 2.0f;
+    const float valenceBoostPower = 0.5f;
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // triangles using each vertex; the first remaining[v] entries of a vertex's range are the ones not yet emitted
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        remaining[indices[i]]++;
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacency[filled[indices[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    struct Scorer
+    {
+        float cacheDecayPower, lastTriangleScore, valenceBoostScale, valenceBoostPower;
+        int cacheSize;
+        float operator()(int position, unsigned int triangles) const
+        {
+            if (triangles == 0)
+                return -1.0f; // no triangles left to emit, the vertex is of no use
+            float score = 0.0f;
+            if (position >= 0)
+            {
+                if (position < 3)
+                    score = lastTriangleScore; // part of the last triangle, no preference between its vertices
+                else
+                    score = std::pow(1.0f - (float)(position - 3) / (cacheSize - 3), cacheDecayPower);
+            }
+            // prefer vertices with few triangles left so they don't linger as isolated leftovers
+            return score + valenceBoostScale * std::pow((float)triangles, -valenceBoostPower);
+        }
+    };
+    Scorer scorer = { cacheDecayPower, lastTriangleScore, valenceBoostScale, valenceBoostPower, cacheSize };
+    for (unsigned int v = 0; v < vertexCount; v++)
+        vertexScores[v] = scorer(-1, remaining[v]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++)
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(cacheSize + 3);
+    nextCache.reserve(cacheSize + 3);
+    size_t scan = 0; // everything before this triangle is emitted
+    long best = 0;
+    for (size_t t = 1; t < triangleCount; t++)
+        if (triangleScores[t] > triangleScores[best])
+            best = (long)t;
+
+    for (size_t count = 0; count < triangleCount; count++)
+    {
+        if (best < 0)
+        {
+            // nothing in the cache touches an unemitted triangle anymore, continue with the next unemitted one
+            while (emitted[scan])
+                scan++;
+            best = (long)scan;
+        }
+        const unsigned int *triangle = &indices[best * 3];
+        emitted[best] = true;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangle[k];
+            output.push_back(v);
+            // remove the triangle from the vertex's unemitted list
+            unsigned int *first = &adjacency[offsets[v]];
+            unsigned int *last = first + remaining[v] - 1;
+            *std::find(first, last + 1, (unsigned int)best) = *last;
+            remaining[v]--;
+        }
+
+        // the triangle's vertices move to the front of the cache, the rest shifts back
+        nextCache.assign(triangle, triangle + 3);
+        for (unsigned int i = 0; i < cache.size(); i++)
+            if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+                nextCache.push_back(cache[i]);
+        for (unsigned int i = 0; i < nextCache.size(); i++)
+        {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = (int)i < cacheSize ? (int)i : -1;
+            vertexScores[v] = scorer(cachePosition[v], remaining[v]);
+        }
+
+        // rescore the triangles around every vertex whose score changed, including the ones just evicted
+        best = -1;
+        float bestScore = -1.0f;
+        for (unsigned int i = 0; i < nextCache.size(); i++)
+        {
+            unsigned int v = nextCache[i];
+            for (unsigned int j = offsets[v]; j < offsets[v] + remaining[v]; j++)
+            {
+                unsigned int t = adjacency[j];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = (long)t;
+                }
+            }
+        }
+        cache.assign(nextCache.begin(), nextCache.begin() + std::min((int)nextCache.size(), cacheSize));
+    }
+    indices.swap(output);
+}
+
+// Overdraw reduction after "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander et al.):
+// the cache optimized triangle order is cut into clusters wherever the cache restarts (hard boundaries) or where a
+// cluster's running ACMR drops below threshold times its overall ACMR (soft boundaries), then the clusters are sorted
+// so the ones facing away from the mesh center, which likely occlude the others, are drawn first.
+// threshold trades cache efficiency for overdraw; 1.05 allows a 5% worse ACMR.
+inline void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, float threshold = 1.05f)
+{
+    const unsigned int cacheSize = 16;
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // hard boundaries: triangles whose three vertices all miss the cache
+    std::vector<unsigned int> cachedAt(vertices.size(), 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<size_t> hardBoundaries;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        unsigned int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (time - cachedAt[v] > cacheSize)
+            {
+                cachedAt[v] = time++;
+                misses++;
+            }
+        }
+        if (misses == 3 || t == 0)
+            hardBoundaries.push_back(t);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // soft boundaries: split hard clusters further as long as every piece keeps a good enough ACMR on its own
+    std::vector<size_t> clusters;
+    for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+    {
+        size_t start = hardBoundaries[c], end = hardBoundaries[c + 1];
+        std::vector<unsigned int> range(indices.begin() + start * 3, indices.begin() + end * 3);
+        float clusterThreshold = threshold * analyzeVertexCache(range, (unsigned int)vertices.size(), cacheSize).acmr();
+
+        std::fill(cachedAt.begin(), cachedAt.end(), 0);
+        time = cacheSize + 1;
+        clusters.push_back(start);
+        size_t clusterStart = start;
+        unsigned int clusterMisses = 0;
+        for (size_t t = start; t < end; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                if (time - cachedAt[v] > cacheSize)
+                {
+                    cachedAt[v] = time++;
+                    clusterMisses++;
+                }
+            }
+            if (t + 1 < end && (float)clusterMisses / (t + 1 - clusterStart) <= clusterThreshold)
+            {
+                clusters.push_back(t + 1);
+                clusterStart = t + 1;
+                clusterMisses = 0;
+                time += cacheSize + 1; // the next cluster may be drawn after any other, so it starts with a cold cache
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // area weighted centroid of the mesh and per cluster centroid and normal
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    size_t clusterCount = clusters.size() - 1;
+    std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float clusterArea = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            const glm::vec3 &a = vertices[indices[t * 3]].Position;
+            const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3 &p = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 normal = glm::cross(b - a, p - a); // length is twice the area
+            float area = glm::length(normal);
+            glm::vec3 centroid = (a + b + p) / 3.0f;
+            clusterCentroids[c] += centroid * area;
+            clusterNormals[c] += normal;
+            clusterArea += area;
+            meshCentroid += centroid * area;
+            meshArea += area;
+        }
+        if (clusterArea > 0.0f)
+            clusterCentroids[c] /= clusterArea;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    std::vector<std::pair<float, size_t> > order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float length = glm::length(clusterNormals[c]);
+        glm::vec3 normal = length > 0.0f ? clusterNormals[c] / length : glm::vec3(0.0f);
+        order[c] = std::make_pair(-glm::dot(clusterCentroids[c] - meshCentroid, normal), c);
+    }
+    std::stable_sort(order.begin(), order.end());
+
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+    for (size_t i = 0; i < clusterCount; i++)
+    {
+        size_t c = order[i].second;
+        output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+    indices.swap(output);
+}
+
+// renumbers vertices in order of first use and drops unreferenced ones; returns the new vertex count
+inline unsigned int optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        unsigned int &index = remap[indices[i]];
+        if (index == unused)
+        {
+            index = (unsigned int)ordered.size();
+            ordered.push_back(vertices[indices[i]]);
+        }
+        indices[i] = index;
+    }
+    vertices.swap(ordered);
+    return (unsigned int)vertices.size();
+}
+
+// runs the whole pipeline in order; before/after (if given) receive the cache statistics of the input and the result
+inline void optimizeMesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                         VertexCacheStats *before = NULL, VertexCacheStats *after = NULL)
+{
+    if (before)
+        *before = analyzeVertexCache(indices, (unsigned int)vertices.size());
+    weldVertices(vertices, indices);
+    optimizeVertexCache(indices, (unsigned int)vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+    if (after)
+        *after = analyzeVertexCache(indices, (unsigned int)vertices.size());
+}
+#endif
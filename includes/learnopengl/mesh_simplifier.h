@@ -0,0 +1,246 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+
+// Mesh simplification by quadric error metric edge collapses (Garland & Heckbert), used to generate the levels of
+// detail of a mesh at import time. Collapses are half-edge collapses: a vertex merges into one of its neighbours,
+// so the simplified index list still refers to the original vertex buffer and every LOD of a mesh can share it.
+// Vertices on open borders and on attribute seams (several vertices at one position, e.g. a UV seam) never move,
+// which keeps the silhouette and texture layout intact at the price of a lower reduction on heavily seamed meshes.
+// ------------------------------------------------------------------------------------------------------
+
+// symmetric 4x4 matrix of a sum of squared plane distances, evaluated as p^T Q p for p = (x, y, z, 1),
+// along with the number of planes in the sum
+struct Quadric
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2, weight;
+
+    Quadric() : a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0), weight(0) {}
+    // plane a*x + b*y + c*z + d = 0 with a unit normal
+    Quadric(double a, double b, double c, double d)
+        : a2(a * a), ab(a * b), ac(a * c), ad(a * d), b2(b * b), bc(b * c), bd(b * d), c2(c * c), cd(c * d), d2(d * d), weight(1) {}
+
+    void add(const Quadric &q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+        bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+        weight += q.weight;
+    }
+    // mean squared distance of p to the planes
+    double error(const glm::vec3 &p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double result = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                      + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                      + c2 * z * z + 2 * cd * z + d2;
+        return result > 0.0 && weight > 0.0 ? result / weight : 0.0;
+    }
+};
+
+// simplifies the triangle list until it has at most targetIndexCount indices or no collapse below targetError (in model
+// space units) is left; returns the new index list and stores the largest error of the collapses made in resultError.
+// The error of a collapse is the root mean square distance of the moved vertex to the planes of all the triangles
+// that were merged into it, a close estimate of how far the simplified surface strays from the original.
+inline std::vector<unsigned int> simplifyMesh(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                              size_t targetIndexCount, float targetError = FLT_MAX, float *resultError = NULL)
+{
+    unsigned int vertexCount = (unsigned int)vertices.size();
+    std::vector<unsigned int> result(indices.begin(), indices.end() - indices.size() % 3);
+    float maxError = 0.0f;
+
+    // vertices sharing a position with another vertex lie on an attribute seam
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3 &p) const
+        {
+            unsigned int bits[3];
+            std::memcpy(bits, &p[0], sizeof(bits));
+            return bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u;
+        }
+    };
+    std::unordered_map<glm::vec3, unsigned int, PositionHash> positionCount;
+    for (unsigned int v = 0; v < vertexCount; v++)
+        positionCount[vertices[v].Position]++;
+    std::vector<bool> locked(vertexCount, false);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        locked[v] = positionCount[vertices[v].Position] > 1;
+
+    // vertices on edges used by a single triangle lie on an open border
+    std::unordered_map<unsigned long long, int> edgeUse;
+    for (size_t i = 0; i < result.size(); i += 3)
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+            edgeUse[(unsigned long long)std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    for (std::unordered_map<unsigned long long, int>::iterator it = edgeUse.begin(); it != edgeUse.end(); ++it)
+        if (it->second == 1)
+            locked[(unsigned int)(it->first >> 32)] = locked[(unsigned int)(it->first & 0xffffffffu)] = true;
+
+    // plane quadrics of the triangles around every vertex
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const glm::vec3 &p0 = vertices[result[i]].Position;
+        glm::vec3 normal = glm::cross(vertices[result[i + 1]].Position - p0, vertices[result[i + 2]].Position - p0);
+        float length = glm::length(normal);
+        if (length == 0.0f)
+            continue;
+        normal /= length;
+        Quadric plane(normal.x, normal.y, normal.z, -glm::dot(normal, p0));
+        for (int k = 0; k < 3; k++)
+            quadrics[result[i + k]].add(plane);
+    }
+
+    // each pass collapses the cheapest edges whose neighbourhoods don't overlap, then rebuilds the index list
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<float> bestCost(vertexCount);
+    std::vector<unsigned int> bestTarget(vertexCount);
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1), triangleList;
+    while (result.size() > targetIndexCount)
+    {
+        size_t triangleCount = result.size() / 3;
+        // triangles around each vertex
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (size_t i = 0; i < result.size(); i++)
+            triangleOffsets[result[i] + 1]++;
+        for (unsigned int v = 0; v < vertexCount; v++)
+            triangleOffsets[v + 1] += triangleOffsets[v];
+        triangleList.resize(result.size());
+        std::vector<unsigned int> filled(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); i++)
+            triangleList[filled[result[i]]++] = (unsigned int)(i / 3);
+
+        // cheapest collapse per vertex
+        std::fill(bestCost.begin(), bestCost.end(), FLT_MAX);
+        for (size_t i = 0; i < result.size(); i += 3)
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int from = result[i + k], to = result[i + (k + 1) % 3];
+                for (int direction = 0; direction < 2; direction++, std::swap(from, to))
+                {
+                    if (locked[from])
+                        continue;
+                    Quadric q = quadrics[from];
+                    q.add(quadrics[to]);
+                    float cost = (float)q.error(vertices[to].Position);
+                    if (cost < bestCost[from])
+                    {
+                        bestCost[from] = cost;
+                        bestTarget[from] = to;
+                    }
+                }
+            }
+        std::vector<std::pair<float, unsigned int> > candidates;
+        for (unsigned int v = 0; v < vertexCount; v++)
+            if (bestCost[v] < FLT_MAX && std::sqrt(bestCost[v]) <= targetError)
+                candidates.push_back(std::make_pair(bestCost[v], v));
+        if (candidates.empty())
+            break;
+        std::sort(candidates.begin(), candidates.end());
+
+        for (unsigned int v = 0; v < vertexCount; v++)
+            remap[v] = v;
+        std::fill(touched.begin(), touched.end(), false);
+        size_t removedTriangles = 0;
+        size_t collapses = 0;
+        for (size_t c = 0; c < candidates.size() && (triangleCount - removedTriangles) * 3 > targetIndexCount; c++)
+        {
+            unsigned int from = candidates[c].second, to = bestTarget[from];
+            if (touched[from] || touched[to])
+                continue;
+            // reject collapses that flip a triangle around the moving vertex or turn it by more than ~75 degrees
+            bool flips = false;
+            size_t removed = 0;
+            for (unsigned int j = triangleOffsets[from]; j < triangleOffsets[from + 1] && !flips; j++)
+            {
+                const unsigned int *triangle = &result[triangleList[j] * 3];
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                {
+                    removed++;
+                    continue;
+                }
+                glm::vec3 p[3], q[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    p[k] = vertices[triangle[k]].Position;
+                    q[k] = triangle[k] == from ? vertices[to].Position : p[k];
+                }
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+            }
+            if (flips)
+                continue;
+
+            remap[from] = to;
+            quadrics[to].add(quadrics[from]);
+            maxError = std::max(maxError, std::sqrt(candidates[c].first));
+            removedTriangles += removed;
+            collapses++;
+            // the whole neighbourhood changed, leave it alone for the rest of this pass
+            for (unsigned int j = triangleOffsets[from]; j < triangleOffsets[from + 1]; j++)
+                for (int k = 0; k < 3; k++)
+                    touched[result[triangleList[j] * 3 + k]] = true;
+        }
+        if (collapses == 0)
+            break;
+
+        // apply the collapses and drop the triangles that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+    if (resultError)
+        *resultError = maxError;
+    return result;
+}
+
+// appends levels of detail to lod 0 (the given indices), each with roughly half the triangles of the previous one,
+// as long as the simplification still makes progress. Returns the LOD ranges into the grown index list.
+inline std::vector<MeshLod> generateLods(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, unsigned int lodLevels)
+{
+    std::vector<MeshLod> lods(1);
+    lods[0].firstIndex = 0;
+    lods[0].indexCount = (unsigned int)indices.size();
+    lods[0].error = 0.0f;
+    std::vector<unsigned int> previous(indices);
+    for (unsigned int level = 1; level < lodLevels; level++)
+    {
+        float error = 0.0f;
+        std::vector<unsigned int> simplified = simplifyMesh(vertices, previous, previous.size() / 2 / 3 * 3, FLT_MAX, &error);
+        // stop once a level doesn't get rid of at least a tenth of the triangles anymore
+        if (simplified.empty() || simplified.size() * 10 > previous.size() * 9)
+            break;
+        MeshLod lod;
+        lod.firstIndex = (unsigned int)indices.size();
+        lod.indexCount = (unsigned int)simplified.size();
+        // the error is measured against the previous level, not lod 0; the distances to the original surface can add
+        // up through every level, so the sum is what bounds this level's deviation from lod 0
+        lod.error = error + lods.back().error;
+        lods.push_back(lod);
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        previous.swap(simplified);
+    }
+    return lods;
+}
+#endif
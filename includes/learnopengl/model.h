@@ -10,14 +10,21 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/frustum.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
+#include <learnopengl/model_cache.h>
+#include <learnopengl/render_queue.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_cache.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
@@ -31,26 +38,104 @@ public:
     vector<Mesh> meshes;
     string directory;
     bool gammaCorrection;
+    Vertex_Format vertexFormat;
+    bool optimizeMeshes;
+    // levels of detail generated per mesh at import, 1 keeps only the full meshes
+    unsigned int lodLevels;
+    // vertex cache statistics of all meshes before and after optimizeMesh(); only filled in with optimizeMeshes enabled,
+    // a model restored from its cache gets the numbers its import stored there
+    VertexCacheStats cacheStatsBefore;
+    VertexCacheStats cacheStatsAfter;
+    // axis aligned bounding box and bounding sphere of all meshes in model space
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    glm::vec3 boundsCenter;
+    float boundsRadius;
 
     /*  Functions   */
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // textures are decoded in parallel by the shared TextureLoader; with waitForTextures disabled the constructor
+    // returns as soon as the meshes are uploaded and the textures show a placeholder until TextureLoader::shared().update() uploads them.
+    // vertexFormat selects the layout the meshes are uploaded in, see PackedVertex for the compact one.
+    // optimize runs the meshes through optimizeMesh() (welding, vertex cache, overdraw and fetch ordering) after the import;
+    // the optimized meshes are what ends up in the binary cache.
+    // lodLevels > 1 adds up to lodLevels - 1 simplified versions of every mesh (see generateLods()), each with about half
+    // the triangles of the previous one; they are cached along with the meshes and drawn by passing a lod to Mesh::Draw.
+    Model(string const &path, bool gamma = false, bool waitForTextures = true, Vertex_Format vertexFormat = FULL_VERTEX, bool optimize = false,
+          unsigned int lodLevels = 1)
+        : gammaCorrection(gamma), vertexFormat(vertexFormat), optimizeMeshes(optimize), lodLevels(lodLevels > 0 ? lodLevels : 1)
     {
         loadModel(path);
+        if(waitForTextures)
+            TextureLoader::shared().finish();
+    }
+
+    // hands the model's textures back to the shared TextureCache, which can then evict the ones nobody else uses.
+    // the model must not be drawn afterwards.
+    void ReleaseTextures()
+    {
+        for(unsigned int i = 0; i < textures_loaded.size(); i++)
+            TextureCache::shared().release(textures_loaded[i].id);
+        textures_loaded.clear();
+        texturesLoadedIndex.clear();
     }
 
     // draws the model, and thus all its meshes
-    void Draw(Shader shader)
+    void Draw(const Shader &shader)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // queues all meshes on the render queue, which draws them sorted by state and depth with modelMatrix as their model uniform
+    void Submit(RenderQueue &queue, const Shader &shader, const glm::mat4 &modelMatrix, unsigned int pass = 0)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            queue.submit(shader, meshes[i], modelMatrix, pass);
+    }
+
+    // whether any part of the model, transformed by modelMatrix, may be inside the frustum
+    bool IsVisible(const Frustum &frustum, const glm::mat4 &modelMatrix) const
+    {
+        return frustum.IntersectsBounds(boundsMin, boundsMax, boundsCenter, boundsRadius, modelMatrix);
+    }
+
+    // draws only the meshes whose bounds, transformed by modelMatrix, intersect the frustum. modelMatrix is only used for
+    // the test, the shader's model uniform still has to be set by the caller. Adds to the frustum's tested/culled counters.
+    void Draw(const Shader &shader, Frustum &frustum, const glm::mat4 &modelMatrix)
+    {
+        frustum.meshesTested += (unsigned int)meshes.size();
+        // reject the whole model at once before looking at its meshes
+        if(!IsVisible(frustum, modelMatrix))
+        {
+            frustum.meshesCulled += (unsigned int)meshes.size();
+            return;
+        }
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            const Mesh &mesh = meshes[i];
+            if(meshes.size() > 1 && !frustum.IntersectsBounds(mesh.boundsMin, mesh.boundsMax, mesh.boundsCenter, mesh.boundsRadius, modelMatrix))
+                frustum.meshesCulled++;
+            else
+                meshes[i].Draw(shader);
+        }
+    }
     
 private:
+    // path -> index into textures_loaded
+    unordered_map<string, unsigned int> texturesLoadedIndex;
+
     /*  Functions   */
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // skip the import entirely if a previous run left an up-to-date binary cache of this model
+        if(loadModelCache(path))
+            return;
+
         // read file via ASSIMP
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -60,11 +145,79 @@ private:
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
-
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+        computeBounds();
+
+        // and store the result so the next run can map it instead of importing again
+        writeModelCache(path, meshes, boundsMin, boundsMax, optimizeMeshes ? MODEL_CACHE_OPTIMIZED : 0, lodLevels, cacheStatsBefore, cacheStatsAfter);
+    }
+
+    // restores the meshes from '<path>.cache', uploading vertices and indices straight from the mapped file.
+    // returns false if there is no cache or it is out of date, in which case the model is imported as usual.
+    bool loadModelCache(string const &path)
+    {
+        MappedFile file;
+        if(!file.open(modelCachePath(path)))
+            return false;
+        const ModelCacheHeader *header = validateModelCache(file, path, optimizeMeshes ? MODEL_CACHE_OPTIMIZED : 0, lodLevels);
+        if(!header)
+            return false;
+        const ModelCacheMesh *meshRecords = (const ModelCacheMesh*)(file.data + sizeof(ModelCacheHeader));
+        const ModelCacheTexture *textureRecords = (const ModelCacheTexture*)(meshRecords + header->meshCount);
+        const ModelCacheLod *lodRecords = (const ModelCacheLod*)(textureRecords + header->textureCount);
+        const char *strings = (const char*)(file.data + header->stringsOffset);
+        if(optimizeMeshes)
+        {
+            cacheStatsBefore = unpackCacheStats(header->cacheStatsBefore);
+            cacheStatsAfter = unpackCacheStats(header->cacheStatsAfter);
+        }
+
+        meshes.reserve(header->meshCount);
+        for(unsigned int i = 0; i < header->meshCount; i++)
+        {
+            const ModelCacheMesh &record = meshRecords[i];
+            vector<Texture> textures;
+            for(unsigned int j = 0; j < record.textureCount; j++)
+            {
+                const ModelCacheTexture &texture = textureRecords[record.firstTexture + j];
+                textures.push_back(loadTexture(strings + texture.pathOffset, strings + texture.typeOffset));
+            }
+            vector<MeshLod> lods;
+            for(unsigned int j = 0; j < record.lodCount; j++)
+            {
+                const ModelCacheLod &lod = lodRecords[record.firstLod + j];
+                MeshLod meshLod = { lod.firstIndex, lod.indexCount, lod.error };
+                lods.push_back(meshLod);
+            }
+            meshes.push_back(Mesh((const Vertex*)(file.data + record.vertexOffset), record.vertexCount,
+                                  (const unsigned int*)(file.data + record.indexOffset), record.indexCount, textures,
+                                  glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]),
+                                  glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]), vertexFormat, lods));
+        }
+        computeBounds();
+        return true;
+    }
+
+    // combines the bounds of all meshes
+    void computeBounds()
+    {
+        boundsMin = boundsMax = glm::vec3(0.0f);
+        bool first = true;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            if(meshes[i].vertexCount == 0)
+                continue;
+            boundsMin = first ? meshes[i].boundsMin : glm::min(boundsMin, meshes[i].boundsMin);
+            boundsMax = first ? meshes[i].boundsMax : glm::max(boundsMax, meshes[i].boundsMax);
+            first = false;
+        }
+        // a sphere around the box center enclosing every mesh's sphere
+        boundsCenter = (boundsMin + boundsMax) * 0.5f;
+        boundsRadius = 0.0f;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            if(meshes[i].vertexCount > 0)
+                boundsRadius = glm::max(boundsRadius, glm::length(meshes[i].boundsCenter - boundsCenter) + meshes[i].boundsRadius);
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -92,6 +245,8 @@ private:
         vector<Vertex> vertices;
         vector<unsigned int> indices;
         vector<Texture> textures;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
 
         // Walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -162,8 +317,31 @@ private:
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
         
+        if(optimizeMeshes)
+        {
+            VertexCacheStats before, after;
+            optimizeMesh(vertices, indices, &before, &after);
+            cacheStatsBefore.add(before);
+            cacheStatsAfter.add(after);
+        }
+        vector<MeshLod> lods;
+        if(lodLevels > 1)
+        {
+            // the simplifier can only move vertices that don't share their position, so split triangles are welded first
+            if(!optimizeMeshes)
+                weldVertices(vertices, indices);
+            lods = generateLods(vertices, indices, lodLevels);
+            // the simplified levels reuse lod 0's vertices but get their own vertex cache friendly triangle order
+            for(unsigned int i = 1; optimizeMeshes && i < lods.size(); i++)
+            {
+                vector<unsigned int> lodIndices(indices.begin() + lods[i].firstIndex, indices.begin() + lods[i].firstIndex + lods[i].indexCount);
+                optimizeVertexCache(lodIndices, (unsigned int)vertices.size());
+                std::copy(lodIndices.begin(), lodIndices.end(), indices.begin() + lods[i].firstIndex);
+            }
+        }
+
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return Mesh(std::move(vertices), std::move(indices), std::move(textures), vertexFormat, std::move(lods));
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -175,29 +353,28 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // returns the texture at the given path (relative to the model). Textures are shared with every other model
+    // through the TextureCache, the model holds one reference per distinct texture.
+    Texture loadTexture(const char *path, const string &typeName)
+    {
+        // check if texture was loaded before and if so, reuse it (optimization)
+        unordered_map<string, unsigned int>::iterator loaded = texturesLoadedIndex.find(path);
+        if(loaded != texturesLoadedIndex.end())
+            return textures_loaded[loaded->second];
+        // if texture hasn't been loaded already, load it
+        Texture texture;
+        texture.id = TextureCache::shared().acquire(this->directory + '/' + path);
+        texture.type = typeName;
+        texture.path = path;
+        texturesLoadedIndex[texture.path] = textures_loaded.size();
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+        return texture;
+    }
 };
 
 
@@ -0,0 +1,433 @@
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/mesh_optimizer.h>
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <cctype>
+#include <sstream>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Binary cache of an imported model, written next to the source file as '<model>.cache' after the first
+// Assimp import. The file starts with a ModelCacheHeader, followed by one ModelCacheMesh per mesh, the texture
+// references, the levels of detail of all meshes and the files the source depends on, a string table and finally the
+// vertex/index blobs in exactly the layout of the Vertex struct, so a cached mesh can be uploaded straight from the
+// mapped file.
+// The cache is rebuilt whenever the version, the Vertex layout or the size/mtime of the source file or one of its
+// dependencies (see modelDependencies()) changes, or when it lacks processing the loader asks for (see the
+// MODEL_CACHE_* flags) or was built with a different number of LOD levels.
+// ------------------------------------------------------------------------------------------------------
+const uint32_t MODEL_CACHE_VERSION = 6;
+const char MODEL_CACHE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'M', 'D', 'L', '\0' };
+
+// processing the cached meshes went through
+const uint32_t MODEL_CACHE_OPTIMIZED = 1; // welded and reordered by optimizeMesh()
+
+struct ModelCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexSize;      // sizeof(Vertex) of the writer
+    uint32_t flags;           // MODEL_CACHE_* flags
+    uint64_t sourceSize;      // size of the source model file in bytes
+    int64_t sourceTime;       // modification time of the source model file
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t lodCount;        // records in the LOD table that follows the texture table
+    uint32_t lodLevels;       // LOD levels the importer was asked to generate per mesh
+    uint32_t dependencyCount; // records in the dependency table that follows the LOD table
+    uint32_t padding;
+    uint64_t stringsOffset;   // offset of the string table (texture types and paths)
+    uint64_t stringsSize;
+    float boundsMin[3];       // bounds of the whole model
+    float boundsMax[3];
+    // VertexCacheStats (triangles, vertices, transforms) of all meshes before and after optimizeMesh(), zero unless
+    // MODEL_CACHE_OPTIMIZED is set, so a cache hit reports the same numbers as the import did
+    uint32_t cacheStatsBefore[3];
+    uint32_t cacheStatsAfter[3];
+};
+
+struct ModelCacheMesh
+{
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;      // of all LODs
+    uint32_t firstTexture;    // into the texture table that follows the meshes
+    uint32_t textureCount;
+    uint32_t firstLod;        // into the LOD table
+    uint32_t lodCount;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+struct ModelCacheTexture
+{
+    uint32_t typeOffset;      // into the string table
+    uint32_t pathOffset;
+};
+
+struct ModelCacheLod
+{
+    uint32_t firstIndex;      // into the mesh's indices
+    uint32_t indexCount;
+    float error;
+    uint32_t padding;
+};
+
+// a file the importer read besides the source, e.g. an OBJ's material library
+struct ModelCacheDependency
+{
+    uint32_t pathOffset;      // into the string table
+    uint32_t padding;
+    uint64_t size;            // size and modification time when the cache was written, both 0 if it didn't exist
+    int64_t time;
+};
+
+// read-only memory mapping of a whole file; the mapping is released when the object goes out of scope
+class MappedFile
+{
+public:
+    MappedFile() : data(NULL), size(0)
+#ifdef _WIN32
+        , file(INVALID_HANDLE_VALUE), mapping(NULL)
+#endif
+    {
+    }
+    ~MappedFile()
+    {
+        close();
+    }
+
+    bool open(const std::string &path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL)
+            data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == NULL)
+        {
+            close();
+            return false;
+        }
+        size = (size_t)fileSize.QuadPart;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        void *mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps its own reference to the file
+        if (mapped == MAP_FAILED)
+            return false;
+        data = (const unsigned char*)mapped;
+        size = (size_t)info.st_size;
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (data != NULL)
+            UnmapViewOfFile(data);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#else
+        if (data != NULL)
+            munmap((void*)data, size);
+#endif
+        data = NULL;
+        size = 0;
+    }
+
+    const unsigned char *data;
+    size_t size;
+
+private:
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+    MappedFile(const MappedFile&);
+    MappedFile &operator=(const MappedFile&);
+};
+
+// size and modification time of a file, used to detect a changed source model
+inline bool modelSourceStamp(const std::string &path, uint64_t &size, int64_t &time)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return false;
+    size = (uint64_t)info.st_size;
+    time = (int64_t)info.st_mtime;
+    return true;
+}
+
+inline void packCacheStats(const VertexCacheStats &stats, uint32_t packed[3])
+{
+    packed[0] = stats.triangles;
+    packed[1] = stats.vertices;
+    packed[2] = stats.transforms;
+}
+
+inline VertexCacheStats unpackCacheStats(const uint32_t packed[3])
+{
+    VertexCacheStats stats;
+    stats.triangles = packed[0];
+    stats.vertices = packed[1];
+    stats.transforms = packed[2];
+    return stats;
+}
+
+inline std::string modelCachePath(const std::string &sourcePath)
+{
+    return sourcePath + ".cache";
+}
+
+// the other files the importer reads for sourcePath, whose changes have to invalidate the cache as well. Only OBJ
+// files have any among the formats the demos use: the material libraries of their 'mtllib' lines, which name the
+// textures. The textures themselves are loaded at run time and need no entry.
+inline std::vector<std::string> modelDependencies(const std::string &sourcePath)
+{
+    std::vector<std::string> files;
+    std::string::size_type dot = sourcePath.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : sourcePath.substr(dot + 1);
+    for (unsigned int i = 0; i < extension.size(); i++)
+        extension[i] = (char)std::tolower((unsigned char)extension[i]);
+    if (extension != "obj")
+        return files;
+    std::string::size_type slash = sourcePath.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "" : sourcePath.substr(0, slash + 1);
+    std::ifstream in(sourcePath.c_str());
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream words(line);
+        std::string keyword, name;
+        if (!(words >> keyword) || keyword != "mtllib")
+            continue;
+        while (words >> name)
+            files.push_back(directory + name);
+    }
+    return files;
+}
+
+// checks the mapped cache file against the source model and the required flags; everything that is read afterwards is bounds checked here
+inline const ModelCacheHeader *validateModelCache(const MappedFile &file, const std::string &sourcePath, uint32_t requiredFlags = 0,
+                                                  uint32_t lodLevels = 1)
+{
+    if (file.size < sizeof(ModelCacheHeader))
+        return NULL;
+    const ModelCacheHeader *header = (const ModelCacheHeader*)file.data;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (std::memcmp(header->magic, MODEL_CACHE_MAGIC, sizeof(MODEL_CACHE_MAGIC)) != 0 ||
+        header->version != MODEL_CACHE_VERSION || header->vertexSize != sizeof(Vertex) ||
+        (header->flags & requiredFlags) != requiredFlags || header->lodLevels != lodLevels ||
+        !modelSourceStamp(sourcePath, sourceSize, sourceTime) ||
+        header->sourceSize != sourceSize || header->sourceTime != sourceTime)
+        return NULL;
+    uint64_t tables = sizeof(ModelCacheHeader) + (uint64_t)header->meshCount * sizeof(ModelCacheMesh) +
+                      (uint64_t)header->textureCount * sizeof(ModelCacheTexture) + (uint64_t)header->lodCount * sizeof(ModelCacheLod) +
+                      (uint64_t)header->dependencyCount * sizeof(ModelCacheDependency);
+    if (tables > file.size || header->stringsOffset + header->stringsSize > file.size || header->stringsSize == 0 ||
+        file.data[header->stringsOffset + header->stringsSize - 1] != '\0')
+        return NULL;
+    const ModelCacheMesh *meshes = (const ModelCacheMesh*)(file.data + sizeof(ModelCacheHeader));
+    const ModelCacheTexture *textures = (const ModelCacheTexture*)(meshes + header->meshCount);
+    const ModelCacheLod *lods = (const ModelCacheLod*)(textures + header->textureCount);
+    for (uint32_t i = 0; i < header->meshCount; i++)
+    {
+        const ModelCacheMesh &mesh = meshes[i];
+        if (mesh.vertexOffset + (uint64_t)mesh.vertexCount * sizeof(Vertex) > file.size ||
+            mesh.indexOffset + (uint64_t)mesh.indexCount * sizeof(unsigned int) > file.size ||
+            (uint64_t)mesh.firstTexture + mesh.textureCount > header->textureCount ||
+            (uint64_t)mesh.firstLod + mesh.lodCount > header->lodCount)
+            return NULL;
+        for (uint32_t j = 0; j < mesh.lodCount; j++)
+            if ((uint64_t)lods[mesh.firstLod + j].firstIndex + lods[mesh.firstLod + j].indexCount > mesh.indexCount)
+                return NULL;
+    }
+    for (uint32_t i = 0; i < header->textureCount; i++)
+        if (textures[i].typeOffset >= header->stringsSize || textures[i].pathOffset >= header->stringsSize)
+            return NULL;
+    // a material library that changed, appeared or disappeared since the cache was written
+    const ModelCacheDependency *dependencies = (const ModelCacheDependency*)(lods + header->lodCount);
+    const char *strings = (const char*)(file.data + header->stringsOffset);
+    for (uint32_t i = 0; i < header->dependencyCount; i++)
+    {
+        if (dependencies[i].pathOffset >= header->stringsSize)
+            return NULL;
+        uint64_t size = 0;
+        int64_t time = 0;
+        modelSourceStamp(strings + dependencies[i].pathOffset, size, time);
+        if (dependencies[i].size != size || dependencies[i].time != time)
+            return NULL;
+    }
+    return header;
+}
+
+// writes the cache for a freshly imported model; failing to write it (e.g. read-only resources) is not an error
+inline bool writeModelCache(const std::string &sourcePath, const std::vector<Mesh> &meshes, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                            uint32_t flags = 0, uint32_t lodLevels = 1, const VertexCacheStats &before = VertexCacheStats(),
+                            const VertexCacheStats &after = VertexCacheStats())
+{
+    ModelCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MODEL_CACHE_MAGIC, sizeof(MODEL_CACHE_MAGIC));
+    header.version = MODEL_CACHE_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.flags = flags;
+    header.lodLevels = lodLevels;
+    if (!modelSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+        return false;
+    header.meshCount = (uint32_t)meshes.size();
+
+    // per mesh records, texture references and the string table
+    std::vector<ModelCacheMesh> meshRecords(meshes.size());
+    std::vector<ModelCacheTexture> textureRecords;
+    std::vector<ModelCacheLod> lodRecords;
+    std::string strings;
+    for (unsigned int i = 0; i < meshes.size(); i++)
+    {
+        const Mesh &mesh = meshes[i];
+        ModelCacheMesh &record = meshRecords[i];
+        std::memset(&record, 0, sizeof(record));
+        record.vertexCount = (uint32_t)mesh.vertices.size();
+        record.indexCount = (uint32_t)mesh.indices.size();
+        record.firstTexture = (uint32_t)textureRecords.size();
+        record.textureCount = (uint32_t)mesh.textures.size();
+        record.firstLod = (uint32_t)lodRecords.size();
+        record.lodCount = (uint32_t)mesh.lods.size();
+        for (unsigned int j = 0; j < mesh.lods.size(); j++)
+        {
+            ModelCacheLod lod = { mesh.lods[j].firstIndex, mesh.lods[j].indexCount, mesh.lods[j].error, 0 };
+            lodRecords.push_back(lod);
+        }
+        for (unsigned int j = 0; j < mesh.textures.size(); j++)
+        {
+            ModelCacheTexture texture;
+            texture.typeOffset = (uint32_t)strings.size();
+            strings.append(mesh.textures[j].type).push_back('\0');
+            texture.pathOffset = (uint32_t)strings.size();
+            strings.append(mesh.textures[j].path).push_back('\0');
+            textureRecords.push_back(texture);
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            record.boundsMin[k] = mesh.boundsMin[k];
+            record.boundsMax[k] = mesh.boundsMax[k];
+        }
+    }
+    std::vector<std::string> dependencyPaths = modelDependencies(sourcePath);
+    std::vector<ModelCacheDependency> dependencyRecords(dependencyPaths.size());
+    for (unsigned int i = 0; i < dependencyPaths.size(); i++)
+    {
+        ModelCacheDependency &dependency = dependencyRecords[i];
+        std::memset(&dependency, 0, sizeof(dependency));
+        modelSourceStamp(dependencyPaths[i], dependency.size, dependency.time);
+        dependency.pathOffset = (uint32_t)strings.size();
+        strings.append(dependencyPaths[i]).push_back('\0');
+    }
+    strings.push_back('\0'); // keeps the table non-empty and terminated
+    header.textureCount = (uint32_t)textureRecords.size();
+    header.lodCount = (uint32_t)lodRecords.size();
+    header.dependencyCount = (uint32_t)dependencyRecords.size();
+    for (int k = 0; k < 3; k++)
+    {
+        header.boundsMin[k] = boundsMin[k];
+        header.boundsMax[k] = boundsMax[k];
+    }
+    packCacheStats(before, header.cacheStatsBefore);
+    packCacheStats(after, header.cacheStatsAfter);
+
+    // lay out the blobs after the tables, 16 byte aligned
+    uint64_t offset = sizeof(ModelCacheHeader) + meshRecords.size() * sizeof(ModelCacheMesh) + textureRecords.size() * sizeof(ModelCacheTexture) +
+                      lodRecords.size() * sizeof(ModelCacheLod) + dependencyRecords.size() * sizeof(ModelCacheDependency);
+    header.stringsOffset = offset;
+    header.stringsSize = strings.size();
+    offset += strings.size();
+    for (unsigned int i = 0; i < meshRecords.size(); i++)
+    {
+        offset = (offset + 15) & ~(uint64_t)15;
+        meshRecords[i].vertexOffset = offset;
+        offset += (uint64_t)meshRecords[i].vertexCount * sizeof(Vertex);
+        offset = (offset + 15) & ~(uint64_t)15;
+        meshRecords[i].indexOffset = offset;
+        offset += (uint64_t)meshRecords[i].indexCount * sizeof(unsigned int);
+    }
+
+    // write to a temporary file first so a partially written cache is never picked up
+    std::string path = modelCachePath(sourcePath);
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    out.write((const char*)&header, sizeof(header));
+    if (!meshRecords.empty())
+        out.write((const char*)&meshRecords[0], meshRecords.size() * sizeof(ModelCacheMesh));
+    if (!textureRecords.empty())
+        out.write((const char*)&textureRecords[0], textureRecords.size() * sizeof(ModelCacheTexture));
+    if (!lodRecords.empty())
+        out.write((const char*)&lodRecords[0], lodRecords.size() * sizeof(ModelCacheLod));
+    if (!dependencyRecords.empty())
+        out.write((const char*)&dependencyRecords[0], dependencyRecords.size() * sizeof(ModelCacheDependency));
+    out.write(strings.data(), strings.size());
+    const char padding[16] = { 0 };
+    for (unsigned int i = 0; i < meshRecords.size(); i++)
+    {
+        const Mesh &mesh = meshes[i];
+        out.write(padding, (std::streamsize)(meshRecords[i].vertexOffset - (uint64_t)out.tellp()));
+        if (!mesh.vertices.empty())
+            out.write((const char*)&mesh.vertices[0], mesh.vertices.size() * sizeof(Vertex));
+        out.write(padding, (std::streamsize)(meshRecords[i].indexOffset - (uint64_t)out.tellp()));
+        if (!mesh.indices.empty())
+            out.write((const char*)&mesh.indices[0], mesh.indices.size() * sizeof(unsigned int));
+    }
+    out.close();
+    if (!out)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    std::remove(path.c_str()); // rename doesn't replace existing files on every platform
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+#endif
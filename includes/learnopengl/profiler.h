@@ -0,0 +1,358 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+// Per pass frame timing on the CPU and the GPU. A frame is bracketed by beginFrame()/endFrame() and split into named
+// passes with begin(name)/end(); passes may nest on the CPU, but only the outermost one is also timed on the GPU since
+// GL_TIME_ELAPSED queries can't overlap. Passes outside of a frame (e.g. precomputation at startup) are timed too.
+// The GPU queries of a frame go into one slot of a ring of 'latency' slots and are only read back when the slot comes
+// around again, by which time the GPU has long finished them, so profiling never stalls the pipeline. Passes outside
+// of a frame have a slot of their own that beginFrame() only reads once the driver reports its results available.
+// Every pass's per frame total is kept for the p50/p95/p99 report and every individual pass as an event for the CSV
+// and Chrome trace (chrome://tracing, ui.perfetto.dev) exports. GPU times no pass could have taken (longer than the
+// profiler has existed, which some drivers' timer queries return) are left out and only counted in the report.
+// ------------------------------------------------------------------------------------------------------
+class Profiler
+{
+public:
+    // trace events beyond this are dropped, the statistics keep going
+    size_t eventLimit;
+
+    Profiler(unsigned int latency = 4) : eventLimit(1 << 20), slots(latency > 0 ? latency : 1), frame(0), inFrame(false), gpuDepth(-1)
+    {
+        epoch = std::chrono::steady_clock::now();
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuEpoch = gpuNow;
+        frameName = nameIndex("frame");
+    }
+    ~Profiler()
+    {
+        for (unsigned int i = 0; i < slots.size(); i++)
+            deleteQueries(slots[i]);
+        deleteQueries(outside);
+    }
+
+    void beginFrame()
+    {
+        double now = elapsed();
+        if (frame > 0)
+            addSample(cpuSamples, frameName, now - frameStart);
+        frameStart = now;
+        inFrame = true;
+        // this slot was last used 'latency' frames ago, its results are ready by now
+        readBack(slots[frame % slots.size()], true);
+        // passes since the last frame may still be running on the GPU, they wait for a later frame if they are
+        if (gpuDepth < 0)
+            readBack(outside, false);
+    }
+    void endFrame()
+    {
+        while (!open.empty())
+            end();
+        for (std::map<unsigned int, double>::iterator it = cpuFrameTotals.begin(); it != cpuFrameTotals.end(); ++it)
+            addSample(cpuSamples, it->first, it->second);
+        cpuFrameTotals.clear();
+        inFrame = false;
+        frame++;
+    }
+
+    void begin(const std::string &name)
+    {
+        OpenPass pass;
+        pass.name = nameIndex(name);
+        pass.start = elapsed();
+        pass.gpu = gpuDepth < 0;
+        if (pass.gpu)
+        {
+            Slot &slot = inFrame ? slots[frame % slots.size()] : outside;
+            if (slot.passes.size() == slot.elapsedQueries.size())
+            {
+                unsigned int queries[2];
+                glGenQueries(2, queries);
+                slot.elapsedQueries.push_back(queries[0]);
+                slot.timestampQueries.push_back(queries[1]);
+            }
+            unsigned int index = (unsigned int)slot.passes.size();
+            GPUPass gpuPass = { pass.name, frame, (unsigned int)open.size(), inFrame };
+            slot.passes.push_back(gpuPass);
+            glQueryCounter(slot.timestampQueries[index], GL_TIMESTAMP);
+            glBeginQuery(GL_TIME_ELAPSED, slot.elapsedQueries[index]);
+            gpuDepth = (int)open.size();
+        }
+        open.push_back(pass);
+    }
+    void end()
+    {
+        if (open.empty())
+            return;
+        OpenPass pass = open.back();
+        open.pop_back();
+        double duration = elapsed() - pass.start;
+        if (pass.gpu)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            gpuDepth = -1;
+        }
+        if (inFrame)
+            cpuFrameTotals[pass.name] += duration;
+        else
+            addSample(cpuSamples, pass.name, duration);
+        addEvent(pass.name, frame, false, (unsigned int)open.size(), pass.start, duration);
+    }
+
+    unsigned int frameCount() const { return frame; }
+
+    // reads back the queries still in flight; waits for the GPU
+    void finish()
+    {
+        for (unsigned int i = 0; i < slots.size(); i++)
+            readBack(slots[(frame + i) % slots.size()], true);
+        readBack(outside, true);
+    }
+
+    // table of every pass's mean and percentiles in milliseconds, per frame
+    void report(std::ostream &out)
+    {
+        finish();
+        out << std::left << std::setw(24) << "pass" << std::setw(6) << "time" << std::right << std::setw(8) << "frames"
+            << std::setw(12) << "mean" << std::setw(12) << "p50" << std::setw(12) << "p95" << std::setw(12) << "p99" << "  (ms)" << std::endl;
+        for (unsigned int name = 0; name < names.size(); name++)
+        {
+            reportLine(out, name, "CPU", cpuSamples, 0);
+            std::map<unsigned int, unsigned int>::const_iterator implausible = implausibleGPU.find(name);
+            reportLine(out, name, "GPU", gpuSamples, implausible != implausibleGPU.end() ? implausible->second : 0);
+        }
+    }
+
+    // one line per pass: frame,pass,timeline,depth,start_ms,duration_ms
+    bool writeCSV(const std::string &path)
+    {
+        finish();
+        std::ofstream out(path.c_str(), std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "ERROR::PROFILER::Failed to write " << path << std::endl;
+            return false;
+        }
+        out << "frame,pass,timeline,depth,start_ms,duration_ms\n";
+        for (unsigned int i = 0; i < events.size(); i++)
+        {
+            const Event &event = events[i];
+            out << event.frame << "," << names[event.name] << "," << (event.gpu ? "GPU" : "CPU") << "," << event.depth << ","
+                << event.start << "," << event.duration << "\n";
+        }
+        return (bool)out;
+    }
+
+    // Chrome trace event format with the CPU and the GPU as two threads
+    bool writeChromeTrace(const std::string &path)
+    {
+        finish();
+        std::ofstream out(path.c_str(), std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "ERROR::PROFILER::Failed to write " << path << std::endl;
+            return false;
+        }
+        out << std::fixed << std::setprecision(3);
+        out << "{\"traceEvents\":[\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+        for (unsigned int i = 0; i < events.size(); i++)
+        {
+            const Event &event = events[i];
+            out << ",\n{\"name\":\"" << names[event.name] << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << (event.gpu ? 1 : 0)
+                << ",\"ts\":" << event.start * 1000.0 << ",\"dur\":" << event.duration * 1000.0
+                << ",\"args\":{\"frame\":" << event.frame << "}}";
+        }
+        out << "\n]}\n";
+        return (bool)out;
+    }
+
+private:
+    struct GPUPass
+    {
+        unsigned int name;
+        unsigned int frame;
+        unsigned int depth;
+        bool inFrame;
+    };
+    // queries of one frame; a slot's query objects are reused by every frame that lands in it
+    struct Slot
+    {
+        std::vector<GPUPass> passes;
+        std::vector<unsigned int> elapsedQueries;
+        std::vector<unsigned int> timestampQueries;
+    };
+    struct OpenPass
+    {
+        unsigned int name;
+        double start;
+        bool gpu;
+    };
+    struct Event
+    {
+        unsigned int name;
+        unsigned int frame;
+        unsigned int depth;
+        bool gpu;
+        double start, duration; // milliseconds since the profiler was created
+    };
+    typedef std::map<unsigned int, std::vector<double> > Samples;
+
+    std::vector<Slot> slots;
+    Slot outside; // passes outside of beginFrame()/endFrame()
+    unsigned int frame;
+    bool inFrame;
+    int gpuDepth; // nesting depth of the pass timed on the GPU, -1 if none is
+    double frameStart;
+    std::chrono::steady_clock::time_point epoch;
+    GLint64 gpuEpoch;
+    unsigned int frameName;
+    std::vector<OpenPass> open;
+    std::vector<std::string> names;
+    std::map<std::string, unsigned int> nameIndices;
+    std::map<unsigned int, double> cpuFrameTotals;
+    Samples cpuSamples, gpuSamples;
+    std::map<unsigned int, unsigned int> implausibleGPU; // GPU times left out of gpuSamples, per pass
+    std::vector<Event> events;
+
+    double elapsed() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    unsigned int nameIndex(const std::string &name)
+    {
+        std::map<std::string, unsigned int>::iterator it = nameIndices.find(name);
+        if (it != nameIndices.end())
+            return it->second;
+        names.push_back(name);
+        return nameIndices[name] = (unsigned int)names.size() - 1;
+    }
+
+    void addSample(Samples &samples, unsigned int name, double milliseconds)
+    {
+        samples[name].push_back(milliseconds);
+    }
+
+    void addEvent(unsigned int name, unsigned int eventFrame, bool gpu, unsigned int depth, double start, double duration)
+    {
+        if (events.size() >= eventLimit)
+            return;
+        Event event = { name, eventFrame, depth, gpu, start, duration };
+        events.push_back(event);
+    }
+
+    void deleteQueries(Slot &slot)
+    {
+        if (!slot.elapsedQueries.empty())
+            glDeleteQueries((GLsizei)slot.elapsedQueries.size(), &slot.elapsedQueries[0]);
+        if (!slot.timestampQueries.empty())
+            glDeleteQueries((GLsizei)slot.timestampQueries.size(), &slot.timestampQueries[0]);
+    }
+
+    // collects the GPU times of the slot's passes and empties it; without wait a slot whose last query hasn't
+    // finished is left for later (queries finish in order, so the others have then too)
+    void readBack(Slot &slot, bool wait)
+    {
+        if (slot.passes.empty())
+            return;
+        if (!wait)
+        {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(slot.elapsedQueries[slot.passes.size() - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return;
+        }
+        std::map<unsigned int, double> totals;
+        double frameTotal = 0.0;
+        bool frameTimed = false, framePlausible = true;
+        // every pass was issued after the profiler was created, none can have taken longer than it has existed
+        double limit = elapsed();
+        for (unsigned int i = 0; i < slot.passes.size(); i++)
+        {
+            GLuint64 nanoseconds = 0, timestamp = 0;
+            glGetQueryObjectui64v(slot.elapsedQueries[i], GL_QUERY_RESULT, &nanoseconds);
+            glGetQueryObjectui64v(slot.timestampQueries[i], GL_QUERY_RESULT, &timestamp);
+            double duration = nanoseconds / 1e6;
+            if (duration > limit)
+            {
+                implausibleGPU[slot.passes[i].name]++;
+                framePlausible = framePlausible && !slot.passes[i].inFrame;
+                continue;
+            }
+            totals[slot.passes[i].name] += duration;
+            // the GPU frame time is the sum of its passes, work outside any pass isn't timed
+            if (slot.passes[i].inFrame)
+            {
+                frameTotal += duration;
+                frameTimed = true;
+            }
+            addEvent(slot.passes[i].name, slot.passes[i].frame, true, slot.passes[i].depth, ((GLint64)timestamp - gpuEpoch) / 1e6, duration);
+        }
+        for (std::map<unsigned int, double>::iterator it = totals.begin(); it != totals.end(); ++it)
+            addSample(gpuSamples, it->first, it->second);
+        if (frameTimed && framePlausible)
+            addSample(gpuSamples, frameName, frameTotal);
+        else if (frameTimed)
+            implausibleGPU[frameName]++;
+        slot.passes.clear();
+    }
+
+    static double percentile(const std::vector<double> &sorted, double p)
+    {
+        size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+        return sorted[rank > 0 ? rank - 1 : 0];
+    }
+
+    // implausible is the number of samples left out, noted after the columns (which are '-' if nothing else is left)
+    void reportLine(std::ostream &out, unsigned int name, const char *timeline, const Samples &samples, unsigned int implausible) const
+    {
+        Samples::const_iterator it = samples.find(name);
+        if ((it == samples.end() || it->second.empty()) && implausible == 0)
+            return;
+        std::vector<double> sorted;
+        if (it != samples.end())
+            sorted = it->second;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (unsigned int i = 0; i < sorted.size(); i++)
+            sum += sorted[i];
+        out << std::left << std::setw(24) << names[name] << std::setw(6) << timeline << std::right << std::setw(8) << sorted.size();
+        if (sorted.empty())
+            out << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12) << "-";
+        else
+            out << std::fixed << std::setprecision(3) << std::setw(12) << sum / sorted.size() << std::setw(12) << percentile(sorted, 50.0)
+                << std::setw(12) << percentile(sorted, 95.0) << std::setw(12) << percentile(sorted, 99.0);
+        if (implausible > 0)
+            out << "  (" << implausible << " implausible left out)";
+        out << std::endl;
+        out.unsetf(std::ios::fixed);
+    }
+};
+
+// times the enclosing block as a pass of profiler
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler &profiler, const std::string &name) : profiler(profiler) { profiler.begin(name); }
+    ~ProfileScope() { profiler.end(); }
+private:
+    Profiler &profiler;
+    ProfileScope(const ProfileScope&);
+    ProfileScope &operator=(const ProfileScope&);
+};
+#endif
@@ -0,0 +1,236 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+// Disk cache of linked shader programs, so a demo compiles its shaders once instead of on every launch. A program is
+// keyed by a hash of its stage sources (as handed to glShaderSource) together with the driver's vendor, renderer
+// and version strings, and stored as '<directory>/<key>.bin': a ProgramCacheHeader followed by the blob from
+// glGetProgramBinary. Loading hands the blob back to glProgramBinary; when the driver rejects it (it was updated,
+// or the blob is damaged) the caller compiles from source as usual and the entry is overwritten.
+// Needs OpenGL 4.1 and a driver offering at least one binary format, otherwise every lookup misses and nothing is
+// written. Shader uses the shared() cache for all its programs.
+// ------------------------------------------------------------------------------------------------------
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+const char PROGRAM_CACHE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'P', 'R', 'G', '\0' };
+
+struct ProgramCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t format;          // binary format reported by glGetProgramBinary
+    uint64_t key;             // the key the file name was made from, so a file renamed or copied to another key's
+                              // name is ignored. Two sources hashing to the same key still share one entry.
+    uint64_t length;          // of the binary that follows
+};
+
+class ProgramCache
+{
+public:
+    struct Stats
+    {
+        unsigned int hits;        // programs restored from disk
+        unsigned int misses;      // programs compiled from source, including rejected ones
+        unsigned int rejected;    // cache files the driver didn't accept
+        unsigned int stores;      // programs written to disk
+        double hitMilliseconds;   // time spent restoring programs
+        double missMilliseconds;  // time spent compiling and linking programs, measured by the caller
+    };
+
+    // set to false to always compile from source
+    bool enabled;
+    // where the cache files go, relative to the working directory unless absolute
+    std::string directory;
+
+    static ProgramCache &shared()
+    {
+        static ProgramCache cache;
+        return cache;
+    }
+
+    ProgramCache() : enabled(true), directory("program_cache"), supported(-1)
+    {
+        stats = Stats();
+    }
+
+    // key of a program built from the given stage sources, in the order they're attached
+    uint64_t key(const std::vector<std::string> &sources)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        hash = hashString(hash, driver());
+        for (unsigned int i = 0; i < sources.size(); i++)
+        {
+            // the separator keeps 'ab' + 'c' from hashing like 'a' + 'bc'
+            hash = hashString(hash, sources[i]);
+            hash = (hash ^ 0xFF) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // restores program from the cache; on success program is linked and ready to use. Call before attaching shaders.
+    bool load(GLuint program, uint64_t key)
+    {
+        if (!enabled || !available())
+            return false;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::ifstream file(path(key).c_str(), std::ios::binary);
+        if (!file)
+            return false;
+        ProgramCacheHeader header;
+        if (!file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != PROGRAM_CACHE_VERSION || header.key != key)
+            return false;
+        binary.resize((size_t)header.length);
+        if (header.length == 0 || !file.read(&binary[0], binary.size()))
+            return false;
+        glProgramBinary(program, header.format, &binary[0], (GLsizei)binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            stats.rejected++;
+            return false;
+        }
+        stats.hits++;
+        stats.hitMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    // asks the driver to keep program's binary retrievable; call before linking a program that will be stored
+    void prepare(GLuint program)
+    {
+        if (enabled && available())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // writes program, just compiled and linked from source, to the cache; compileMilliseconds is what that took.
+    // Programs that failed to link are only counted.
+    void store(GLuint program, uint64_t key, double compileMilliseconds)
+    {
+        stats.misses++;
+        stats.missMilliseconds += compileMilliseconds;
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!enabled || !linked || !available())
+            return;
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        ProgramCacheHeader header;
+        std::memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+        header.version = PROGRAM_CACHE_VERSION;
+        header.key = key;
+        binary.resize(length);
+        GLenum format = 0;
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &format, &binary[0]);
+        if (written <= 0)
+            return;
+        header.format = format;
+        header.length = (uint64_t)written;
+
+        makeDirectory();
+        // written under a temporary name and renamed, so a crash never leaves a truncated entry behind
+        std::string target = path(key), temporary = target + ".tmp";
+        std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cout << "ERROR::PROGRAM_CACHE::Could not write " << temporary << std::endl;
+            return;
+        }
+        file.write((const char*)&header, sizeof(header));
+        file.write(&binary[0], written);
+        file.close();
+        std::remove(target.c_str());
+        if (!file || std::rename(temporary.c_str(), target.c_str()) != 0)
+        {
+            std::cout << "ERROR::PROGRAM_CACHE::Could not write " << target << std::endl;
+            std::remove(temporary.c_str());
+            return;
+        }
+        stats.stores++;
+    }
+
+    const Stats &statistics() const { return stats; }
+
+    void report(std::ostream &out) const
+    {
+        out << "program cache: " << stats.hits << " hits (" << std::fixed << std::setprecision(2) << stats.hitMilliseconds << " ms), "
+            << stats.misses << " misses (" << stats.missMilliseconds << " ms), " << stats.rejected << " rejected, " << stats.stores
+            << " stored" << std::endl;
+    }
+
+private:
+    int supported;
+    std::string driverString;
+    std::vector<char> binary;
+    Stats stats;
+
+    // program binaries need GL 4.1 and at least one format; checked once a context exists
+    bool available()
+    {
+        if (supported < 0)
+        {
+            GLint formats = 0;
+            if (GLAD_GL_VERSION_4_1)
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            supported = formats > 0 ? 1 : 0;
+        }
+        return supported == 1;
+    }
+
+    const std::string &driver()
+    {
+        if (driverString.empty())
+        {
+            const char *strings[3] = { (const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION) };
+            for (unsigned int i = 0; i < 3; i++)
+                driverString += std::string(strings[i] ? strings[i] : "") + "\n";
+        }
+        return driverString;
+    }
+
+    static uint64_t hashString(uint64_t hash, const std::string &text)
+    {
+        for (unsigned int i = 0; i < text.size(); i++)
+        {
+            hash ^= (unsigned char)text[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string path(uint64_t key) const
+    {
+        std::ostringstream name;
+        name << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+        return name.str();
+    }
+
+    void makeDirectory() const
+    {
+#ifdef _WIN32
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(), 0755);
+#endif
+    }
+};
+#endif
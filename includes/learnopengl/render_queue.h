@@ -0,0 +1,256 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cmath>
+#include <cstdint>
+
+// Collects the draws of a frame and submits them in an order that keeps state changes and overdraw down. Every draw
+// gets a 64 bit sort key and flush() radix sorts the keys before drawing. Opaque draws are ordered by
+//     pass (4) | 0 (1) | shader (10) | material (14) | depth (16) | vertex array (19)
+// so draws sharing a program and texture set end up next to each other and are drawn front to back among themselves.
+// Passes marked transparent with setTransparent() are ordered by
+//     pass (4) | 1 (1) | inverted depth (24) | shader (10) | material (14) | vertex array (11)
+// which draws them strictly back to front. Depth is the distance of the draw's bounding sphere center along the view
+// direction, spread logarithmically between the near and far plane. Shaders and materials are numbered in the order the
+// queue first sees them; a field that overflows its bits only makes the ordering less ideal, never wrong.
+// ------------------------------------------------------------------------------------------------------
+class RenderQueue
+{
+public:
+    // one queued draw
+    struct Item
+    {
+        uint64_t key;
+        const Shader *shader;
+        Mesh *mesh;          // drawn with Mesh::Draw, NULL for geometry drawn by draw
+        unsigned int lod;
+        glm::mat4 model;
+        // sets the item's own uniforms before its mesh is drawn, or draws the item itself when it has no mesh
+        std::function<void(const Shader&)> draw;
+    };
+    // what the last flush() submitted
+    struct Stats
+    {
+        unsigned int draws;
+        unsigned int programChanges;
+        unsigned int materialChanges;
+        unsigned int vertexArrayChanges;
+    };
+
+    // name of the model matrix uniform every item's matrix is uploaded to
+    std::string modelUniform;
+
+    RenderQueue() : modelUniform("model"), transparentPasses(0), viewPosition(0.0f), viewDirection(0.0f, 0.0f, -1.0f), nearPlane(0.1f), farPlane(100.0f)
+    {
+        stats = Stats();
+    }
+
+    // camera the depth of the items is measured from; set before submitting the frame's items
+    void setView(const glm::vec3 &position, const glm::vec3 &front, float nearPlane, float farPlane)
+    {
+        viewPosition = position;
+        viewDirection = glm::normalize(front);
+        this->nearPlane = nearPlane;
+        this->farPlane = farPlane;
+    }
+
+    // items of a transparent pass are drawn back to front instead of by state
+    void setTransparent(unsigned int pass, bool transparent = true)
+    {
+        if (transparent)
+            transparentPasses |= 1u << (pass & 15);
+        else
+            transparentPasses &= ~(1u << (pass & 15));
+    }
+
+    // queues mesh, drawn with shader and model as its model matrix; setup sets any uniforms of its own
+    void submit(const Shader &shader, Mesh &mesh, const glm::mat4 &model, unsigned int pass = 0, unsigned int lod = 0,
+                std::function<void(const Shader&)> setup = std::function<void(const Shader&)>())
+    {
+        glm::vec3 center = glm::vec3(model * glm::vec4(mesh.boundsCenter, 1.0f));
+        Item item;
+        item.key = makeKey(pass, shaderIndex(shader), meshMaterial(mesh), center, mesh.VAO);
+        item.shader = &shader;
+        item.mesh = &mesh;
+        item.lod = lod;
+        item.model = model;
+        item.draw = setup;
+        items.push_back(item);
+    }
+
+    // queues geometry the caller draws itself, e.g. the demos' renderSphere(). center is the world space position its
+    // depth is measured at, VAO and material (any number identifying its textures) only serve the sorting.
+    void submit(const Shader &shader, unsigned int VAO, unsigned int material, const glm::vec3 &center, const glm::mat4 &model,
+                std::function<void(const Shader&)> draw, unsigned int pass = 0)
+    {
+        Item item;
+        item.key = makeKey(pass, shaderIndex(shader), material, center, VAO);
+        item.shader = &shader;
+        item.mesh = NULL;
+        item.lod = 0;
+        item.model = model;
+        item.draw = draw;
+        items.push_back(item);
+    }
+
+    unsigned int size() const { return (unsigned int)items.size(); }
+
+    // sorts and draws every queued item, then empties the queue
+    void flush()
+    {
+        sortItems();
+        stats = Stats();
+        const Shader *shader = NULL;
+        Shader::UniformHandle model;
+        uint64_t lastMaterial = ~(uint64_t)0, lastVertexArray = ~(uint64_t)0;
+        for (unsigned int i = 0; i < order.size(); i++)
+        {
+            const Item &item = items[order[i].index];
+            if (item.shader != shader)
+            {
+                shader = item.shader;
+                shader->use();
+                model = shader->uniformHandle(modelUniform);
+                stats.programChanges++;
+            }
+            uint64_t material = materialBits(item.key), vertexArray = vertexArrayBits(item.key);
+            if (material != lastMaterial)
+                stats.materialChanges++;
+            if (vertexArray != lastVertexArray)
+                stats.vertexArrayChanges++;
+            lastMaterial = material;
+            lastVertexArray = vertexArray;
+
+            shader->setMat4(model, item.model);
+            if (item.draw)
+                item.draw(*shader);
+            if (item.mesh)
+                item.mesh->Draw(*shader, item.lod);
+            stats.draws++;
+        }
+        items.clear();
+    }
+
+    const Stats &lastFlush() const { return stats; }
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        unsigned int index;
+    };
+
+    std::vector<Item> items;
+    std::vector<SortEntry> order, scratch;
+    std::unordered_map<unsigned int, unsigned int> shaderIndices;
+    std::unordered_map<uint64_t, unsigned int> materialIndices;
+    unsigned int transparentPasses;
+    glm::vec3 viewPosition;
+    glm::vec3 viewDirection;
+    float nearPlane, farPlane;
+    Stats stats;
+
+    bool transparent(uint64_t key) const
+    {
+        return (key >> 59 & 1) != 0;
+    }
+    uint64_t materialBits(uint64_t key) const
+    {
+        return transparent(key) ? key >> 11 & 0x3FFF : key >> 35 & 0x3FFF;
+    }
+    uint64_t vertexArrayBits(uint64_t key) const
+    {
+        return transparent(key) ? key & 0x7FF : key & 0x7FFFF;
+    }
+
+    uint64_t makeKey(unsigned int pass, unsigned int shader, unsigned int material, const glm::vec3 &center, unsigned int VAO) const
+    {
+        uint64_t key = (uint64_t)(pass & 15) << 60;
+        float depth = normalizedDepth(center);
+        if (transparentPasses & (1u << (pass & 15)))
+        {
+            uint64_t farToNear = (uint64_t)((1.0f - depth) * 0xFFFFFF + 0.5f);
+            key |= (uint64_t)1 << 59 | farToNear << 35 | (uint64_t)(shader & 0x3FF) << 25 | (uint64_t)(material & 0x3FFF) << 11 | (VAO & 0x7FF);
+        }
+        else
+        {
+            uint64_t nearToFar = (uint64_t)(depth * 0xFFFF + 0.5f);
+            key |= (uint64_t)(shader & 0x3FF) << 49 | (uint64_t)(material & 0x3FFF) << 35 | nearToFar << 19 | (VAO & 0x7FFFF);
+        }
+        return key;
+    }
+
+    // view depth of point mapped to [0, 1] logarithmically, so nearby draws get the finer buckets
+    float normalizedDepth(const glm::vec3 &point) const
+    {
+        float depth = glm::dot(point - viewPosition, viewDirection);
+        if (depth <= nearPlane)
+            return 0.0f;
+        if (depth >= farPlane)
+            return 1.0f;
+        return std::log(depth / nearPlane) / std::log(farPlane / nearPlane);
+    }
+
+    unsigned int shaderIndex(const Shader &shader)
+    {
+        std::unordered_map<unsigned int, unsigned int>::iterator it = shaderIndices.find(shader.ID);
+        if (it != shaderIndices.end())
+            return it->second;
+        return shaderIndices[shader.ID] = (unsigned int)shaderIndices.size();
+    }
+
+    // meshes with the same textures share a material number
+    unsigned int meshMaterial(const Mesh &mesh)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned int i = 0; i < mesh.textures.size(); i++)
+        {
+            hash ^= mesh.textures[i].id;
+            hash *= 1099511628211ull;
+        }
+        std::unordered_map<uint64_t, unsigned int>::iterator it = materialIndices.find(hash);
+        if (it != materialIndices.end())
+            return it->second;
+        return materialIndices[hash] = (unsigned int)materialIndices.size();
+    }
+
+    // least significant digit radix sort of the keys, a byte per pass; passes over a byte all keys share are skipped
+    void sortItems()
+    {
+        order.resize(items.size());
+        scratch.resize(items.size());
+        for (unsigned int i = 0; i < items.size(); i++)
+        {
+            order[i].key = items[i].key;
+            order[i].index = i;
+        }
+        for (unsigned int shift = 0; shift < 64; shift += 8)
+        {
+            unsigned int counts[256] = { 0 };
+            for (unsigned int i = 0; i < order.size(); i++)
+                counts[order[i].key >> shift & 0xFF]++;
+            if (order.empty() || counts[order[0].key >> shift & 0xFF] == order.size())
+                continue;
+            unsigned int offsets[256];
+            unsigned int offset = 0;
+            for (unsigned int digit = 0; digit < 256; digit++)
+            {
+                offsets[digit] = offset;
+                offset += counts[digit];
+            }
+            for (unsigned int i = 0; i < order.size(); i++)
+                scratch[offsets[order[i].key >> shift & 0xFF]++] = order[i];
+            order.swap(scratch);
+        }
+    }
+};
+#endif
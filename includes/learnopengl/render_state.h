@@ -0,0 +1,461 @@
+#ifndef RENDER_STATE_H
+#define RENDER_STATE_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+// Shadow copy of the GL state the demos and helpers change most often: the program, vertex array, active texture
+// unit and texture bindings, framebuffers, enabled capabilities and the blend, depth and stencil functions. Calls
+// that would set what is already set are dropped before they reach the driver.
+// The first RenderState::shared() call (made by Shader::use()) points glad's entry points for these calls at the
+// tracker, so raw gl* calls in the demos go through it too and the shadow copy never goes stale. State nobody set
+// through it yet, or that was changed behind glad's back, is unknown and always set. Every call is counted as issued
+// or filtered; endFrame() moves the counts into lastFrame() and report() prints them.
+// ------------------------------------------------------------------------------------------------------
+class RenderState
+{
+public:
+    enum Category
+    {
+        PROGRAM,
+        VERTEX_ARRAY,
+        ACTIVE_TEXTURE,
+        TEXTURE,
+        FRAMEBUFFER,
+        CAPABILITY,
+        BLEND,
+        DEPTH,
+        STENCIL,
+        CATEGORY_COUNT
+    };
+    struct Counters
+    {
+        unsigned long long issued[CATEGORY_COUNT];
+        unsigned long long filtered[CATEGORY_COUNT];
+        Counters() { clear(); }
+        void clear()
+        {
+            for (unsigned int i = 0; i < CATEGORY_COUNT; i++)
+                issued[i] = filtered[i] = 0;
+        }
+        void add(const Counters &other)
+        {
+            for (unsigned int i = 0; i < CATEGORY_COUNT; i++)
+            {
+                issued[i] += other.issued[i];
+                filtered[i] += other.filtered[i];
+            }
+        }
+    };
+
+    static RenderState &shared()
+    {
+        static RenderState state;
+        return state;
+    }
+
+    // forget everything; call this after changing state in ways the tracker doesn't see (e.g. other libraries
+    // with their own GL loader)
+    void invalidate()
+    {
+        program = vertexArray = activeUnit = UNKNOWN;
+        for (unsigned int i = 0; i < TRACKED_UNITS; i++)
+            for (unsigned int j = 0; j < TRACKED_TARGETS; j++)
+                textures[i][j] = UNKNOWN;
+        drawFramebuffer = readFramebuffer = UNKNOWN;
+        capabilities.clear();
+        for (unsigned int i = 0; i < 4; i++)
+            blendFactors[i] = UNKNOWN;
+        depthFunction = depthWrites = UNKNOWN;
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            stencilFunction[i] = stencilReference[i] = stencilValueMask[i] = UNKNOWN;
+            stencilFail[i] = stencilDepthFail[i] = stencilDepthPass[i] = stencilWriteMask[i] = UNKNOWN;
+        }
+    }
+
+    // state changes
+    // ------------------------------------------------------------------------
+    void useProgram(GLuint id)
+    {
+        if (changed(PROGRAM, program, id))
+            real.useProgram(id);
+    }
+    void bindVertexArray(GLuint id)
+    {
+        if (changed(VERTEX_ARRAY, vertexArray, id))
+            real.bindVertexArray(id);
+    }
+    void activeTexture(GLenum unit)
+    {
+        if (changed(ACTIVE_TEXTURE, activeUnit, unit))
+            real.activeTexture(unit);
+    }
+    // binds to the active texture unit
+    void bindTexture(GLenum target, GLuint id)
+    {
+        GLuint *binding = textureBinding(activeUnit, target);
+        if (!binding)
+        {
+            counters.issued[TEXTURE]++;
+            real.bindTexture(target, id);
+        }
+        else if (changed(TEXTURE, *binding, id))
+            real.bindTexture(target, id);
+    }
+    // binds to the given unit (0 for GL_TEXTURE0), only switching the active unit when the binding changes
+    void bindTexture(unsigned int unit, GLenum target, GLuint id)
+    {
+        GLuint *binding = textureBinding(GL_TEXTURE0 + unit, target);
+        if (binding && *binding == id)
+        {
+            counters.filtered[TEXTURE]++;
+            return;
+        }
+        activeTexture(GL_TEXTURE0 + unit);
+        bindTexture(target, id);
+    }
+    void bindFramebuffer(GLenum target, GLuint id)
+    {
+        bool draw = target != GL_READ_FRAMEBUFFER, read = target != GL_DRAW_FRAMEBUFFER;
+        if ((draw && drawFramebuffer != id) || (read && readFramebuffer != id))
+        {
+            counters.issued[FRAMEBUFFER]++;
+            real.bindFramebuffer(target, id);
+            if (draw)
+                drawFramebuffer = id;
+            if (read)
+                readFramebuffer = id;
+        }
+        else
+            counters.filtered[FRAMEBUFFER]++;
+    }
+    void enable(GLenum capability)
+    {
+        if (changed(CAPABILITY, capabilityState(capability), GL_TRUE))
+            real.enable(capability);
+    }
+    void disable(GLenum capability)
+    {
+        if (changed(CAPABILITY, capabilityState(capability), GL_FALSE))
+            real.disable(capability);
+    }
+    void blendFunc(GLenum source, GLenum destination)
+    {
+        blendFuncSeparate(source, destination, source, destination);
+    }
+    void blendFuncSeparate(GLenum sourceColor, GLenum destinationColor, GLenum sourceAlpha, GLenum destinationAlpha)
+    {
+        GLuint factors[4] = { sourceColor, destinationColor, sourceAlpha, destinationAlpha };
+        if (!changed(BLEND, blendFactors, factors, 4))
+            return;
+        if (sourceColor == sourceAlpha && destinationColor == destinationAlpha)
+            real.blendFunc(sourceColor, destinationColor);
+        else
+            real.blendFuncSeparate(sourceColor, destinationColor, sourceAlpha, destinationAlpha);
+    }
+    void depthFunc(GLenum function)
+    {
+        if (changed(DEPTH, depthFunction, function))
+            real.depthFunc(function);
+    }
+    void depthMask(GLboolean writes)
+    {
+        if (changed(DEPTH, depthWrites, writes))
+            real.depthMask(writes);
+    }
+    void stencilFunc(GLenum function, GLint reference, GLuint mask)
+    {
+        GLuint state[6] = { function, (GLuint)reference, mask, function, (GLuint)reference, mask };
+        GLuint current[6] = { stencilFunction[0], stencilReference[0], stencilValueMask[0], stencilFunction[1], stencilReference[1], stencilValueMask[1] };
+        if (!changed(STENCIL, current, state, 6))
+            return;
+        real.stencilFunc(function, reference, mask);
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            stencilFunction[i] = function;
+            stencilReference[i] = (GLuint)reference;
+            stencilValueMask[i] = mask;
+        }
+    }
+    void stencilOp(GLenum fail, GLenum depthFail, GLenum depthPass)
+    {
+        GLuint state[6] = { fail, depthFail, depthPass, fail, depthFail, depthPass };
+        GLuint current[6] = { stencilFail[0], stencilDepthFail[0], stencilDepthPass[0], stencilFail[1], stencilDepthFail[1], stencilDepthPass[1] };
+        if (!changed(STENCIL, current, state, 6))
+            return;
+        real.stencilOp(fail, depthFail, depthPass);
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            stencilFail[i] = fail;
+            stencilDepthFail[i] = depthFail;
+            stencilDepthPass[i] = depthPass;
+        }
+    }
+    void stencilMask(GLuint mask)
+    {
+        GLuint state[2] = { mask, mask };
+        if (changed(STENCIL, stencilWriteMask, state, 2))
+            real.stencilMask(mask);
+    }
+
+    // counters
+    // ------------------------------------------------------------------------
+    // counts of the frame so far
+    const Counters &currentFrame() const { return counters; }
+    // counts of the last frame ended with endFrame()
+    const Counters &lastFrame() const { return previous; }
+    void endFrame()
+    {
+        previous = counters;
+        total.add(counters);
+        counters.clear();
+        frames++;
+    }
+
+    // issued and filtered calls per category of the last frame and on average over all frames
+    void report(std::ostream &out) const
+    {
+        static const char *names[CATEGORY_COUNT] = { "program", "vertex array", "active texture", "texture", "framebuffer", "capability", "blend", "depth", "stencil" };
+        out << std::left << std::setw(16) << "state" << std::right << std::setw(10) << "issued" << std::setw(10) << "filtered"
+            << std::setw(14) << "avg issued" << std::setw(14) << "avg filtered" << std::endl;
+        for (unsigned int i = 0; i < CATEGORY_COUNT; i++)
+        {
+            out << std::left << std::setw(16) << names[i] << std::right << std::setw(10) << previous.issued[i] << std::setw(10) << previous.filtered[i]
+                << std::fixed << std::setprecision(1) << std::setw(14) << average(total.issued[i]) << std::setw(14) << average(total.filtered[i]) << std::endl;
+            out.unsetf(std::ios::fixed);
+        }
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const unsigned int TRACKED_UNITS = 32;
+    static const unsigned int TRACKED_TARGETS = 5;
+
+    // the driver's entry points the hooks forward to
+    struct Entries
+    {
+        PFNGLUSEPROGRAMPROC useProgram;
+        PFNGLBINDVERTEXARRAYPROC bindVertexArray;
+        PFNGLACTIVETEXTUREPROC activeTexture;
+        PFNGLBINDTEXTUREPROC bindTexture;
+        PFNGLBINDFRAMEBUFFERPROC bindFramebuffer;
+        PFNGLENABLEPROC enable;
+        PFNGLDISABLEPROC disable;
+        PFNGLBLENDFUNCPROC blendFunc;
+        PFNGLBLENDFUNCSEPARATEPROC blendFuncSeparate;
+        PFNGLDEPTHFUNCPROC depthFunc;
+        PFNGLDEPTHMASKPROC depthMask;
+        PFNGLSTENCILFUNCPROC stencilFunc;
+        PFNGLSTENCILFUNCSEPARATEPROC stencilFuncSeparate;
+        PFNGLSTENCILOPPROC stencilOp;
+        PFNGLSTENCILOPSEPARATEPROC stencilOpSeparate;
+        PFNGLSTENCILMASKPROC stencilMask;
+        PFNGLSTENCILMASKSEPARATEPROC stencilMaskSeparate;
+        PFNGLDELETEPROGRAMPROC deleteProgram;
+        PFNGLDELETEVERTEXARRAYSPROC deleteVertexArrays;
+        PFNGLDELETETEXTURESPROC deleteTextures;
+        PFNGLDELETEFRAMEBUFFERSPROC deleteFramebuffers;
+    };
+    struct Capability
+    {
+        GLenum capability;
+        GLuint state;
+    };
+
+    Entries real;
+    GLuint program, vertexArray, activeUnit;
+    GLuint textures[TRACKED_UNITS][TRACKED_TARGETS];
+    GLuint drawFramebuffer, readFramebuffer;
+    std::vector<Capability> capabilities;
+    GLuint blendFactors[4];
+    GLuint depthFunction, depthWrites;
+    // front and back face
+    GLuint stencilFunction[2], stencilReference[2], stencilValueMask[2];
+    GLuint stencilFail[2], stencilDepthFail[2], stencilDepthPass[2], stencilWriteMask[2];
+    Counters counters, previous, total;
+    unsigned long long frames;
+
+    RenderState() : frames(0)
+    {
+        invalidate();
+        install();
+    }
+    RenderState(const RenderState&);
+    RenderState &operator=(const RenderState&);
+
+    // swaps glad's function pointers for the hooks below, keeping the originals to forward to
+    void install()
+    {
+        real.useProgram = glad_glUseProgram;                   glad_glUseProgram = hookUseProgram;
+        real.bindVertexArray = glad_glBindVertexArray;         glad_glBindVertexArray = hookBindVertexArray;
+        real.activeTexture = glad_glActiveTexture;             glad_glActiveTexture = hookActiveTexture;
+        real.bindTexture = glad_glBindTexture;                 glad_glBindTexture = hookBindTexture;
+        real.bindFramebuffer = glad_glBindFramebuffer;         glad_glBindFramebuffer = hookBindFramebuffer;
+        real.enable = glad_glEnable;                           glad_glEnable = hookEnable;
+        real.disable = glad_glDisable;                         glad_glDisable = hookDisable;
+        real.blendFunc = glad_glBlendFunc;                     glad_glBlendFunc = hookBlendFunc;
+        real.blendFuncSeparate = glad_glBlendFuncSeparate;     glad_glBlendFuncSeparate = hookBlendFuncSeparate;
+        real.depthFunc = glad_glDepthFunc;                     glad_glDepthFunc = hookDepthFunc;
+        real.depthMask = glad_glDepthMask;                     glad_glDepthMask = hookDepthMask;
+        real.stencilFunc = glad_glStencilFunc;                 glad_glStencilFunc = hookStencilFunc;
+        real.stencilFuncSeparate = glad_glStencilFuncSeparate; glad_glStencilFuncSeparate = hookStencilFuncSeparate;
+        real.stencilOp = glad_glStencilOp;                     glad_glStencilOp = hookStencilOp;
+        real.stencilOpSeparate = glad_glStencilOpSeparate;     glad_glStencilOpSeparate = hookStencilOpSeparate;
+        real.stencilMask = glad_glStencilMask;                 glad_glStencilMask = hookStencilMask;
+        real.stencilMaskSeparate = glad_glStencilMaskSeparate; glad_glStencilMaskSeparate = hookStencilMaskSeparate;
+        real.deleteProgram = glad_glDeleteProgram;             glad_glDeleteProgram = hookDeleteProgram;
+        real.deleteVertexArrays = glad_glDeleteVertexArrays;   glad_glDeleteVertexArrays = hookDeleteVertexArrays;
+        real.deleteTextures = glad_glDeleteTextures;           glad_glDeleteTextures = hookDeleteTextures;
+        real.deleteFramebuffers = glad_glDeleteFramebuffers;   glad_glDeleteFramebuffers = hookDeleteFramebuffers;
+    }
+
+    // records value as the new state; returns whether it differs from the old one and has to be sent
+    bool changed(Category category, GLuint &state, GLuint value)
+    {
+        if (state == value)
+        {
+            counters.filtered[category]++;
+            return false;
+        }
+        counters.issued[category]++;
+        state = value;
+        return true;
+    }
+    bool changed(Category category, GLuint *state, const GLuint *values, unsigned int count)
+    {
+        bool differs = false;
+        for (unsigned int i = 0; i < count; i++)
+            differs = differs || state[i] != values[i];
+        if (!differs)
+        {
+            counters.filtered[category]++;
+            return false;
+        }
+        counters.issued[category]++;
+        for (unsigned int i = 0; i < count; i++)
+            state[i] = values[i];
+        return true;
+    }
+
+    // binding slot of target on the unit, NULL for the units and targets that aren't tracked
+    GLuint *textureBinding(GLuint unit, GLenum target)
+    {
+        int slot = -1;
+        switch (target)
+        {
+        case GL_TEXTURE_2D:             slot = 0; break;
+        case GL_TEXTURE_CUBE_MAP:       slot = 1; break;
+        case GL_TEXTURE_2D_ARRAY:       slot = 2; break;
+        case GL_TEXTURE_2D_MULTISAMPLE: slot = 3; break;
+        case GL_TEXTURE_3D:             slot = 4; break;
+        }
+        if (slot < 0 || unit < GL_TEXTURE0 || unit >= GL_TEXTURE0 + TRACKED_UNITS)
+            return NULL;
+        return &textures[unit - GL_TEXTURE0][slot];
+    }
+
+    GLuint &capabilityState(GLenum capability)
+    {
+        for (unsigned int i = 0; i < capabilities.size(); i++)
+            if (capabilities[i].capability == capability)
+                return capabilities[i].state;
+        Capability entry = { capability, UNKNOWN };
+        capabilities.push_back(entry);
+        return capabilities.back().state;
+    }
+
+    double average(unsigned long long count) const
+    {
+        return frames > 0 ? (double)count / frames : 0.0;
+    }
+
+    // deleting a bound object reverts its binding to 0
+    void deleted(GLuint &binding, GLsizei count, const GLuint *ids)
+    {
+        for (GLsizei i = 0; i < count; i++)
+            if (ids[i] != 0 && binding == ids[i])
+                binding = 0;
+    }
+
+    // hooks glad's entry points are pointed at
+    // ------------------------------------------------------------------------
+    static void APIENTRY hookUseProgram(GLuint id) { shared().useProgram(id); }
+    static void APIENTRY hookBindVertexArray(GLuint id) { shared().bindVertexArray(id); }
+    static void APIENTRY hookActiveTexture(GLenum unit) { shared().activeTexture(unit); }
+    static void APIENTRY hookBindTexture(GLenum target, GLuint id) { shared().bindTexture(target, id); }
+    static void APIENTRY hookBindFramebuffer(GLenum target, GLuint id) { shared().bindFramebuffer(target, id); }
+    static void APIENTRY hookEnable(GLenum capability) { shared().enable(capability); }
+    static void APIENTRY hookDisable(GLenum capability) { shared().disable(capability); }
+    static void APIENTRY hookBlendFunc(GLenum source, GLenum destination) { shared().blendFunc(source, destination); }
+    static void APIENTRY hookBlendFuncSeparate(GLenum sourceColor, GLenum destinationColor, GLenum sourceAlpha, GLenum destinationAlpha)
+    {
+        shared().blendFuncSeparate(sourceColor, destinationColor, sourceAlpha, destinationAlpha);
+    }
+    static void APIENTRY hookDepthFunc(GLenum function) { shared().depthFunc(function); }
+    static void APIENTRY hookDepthMask(GLboolean writes) { shared().depthMask(writes); }
+    static void APIENTRY hookStencilFunc(GLenum function, GLint reference, GLuint mask) { shared().stencilFunc(function, reference, mask); }
+    static void APIENTRY hookStencilOp(GLenum fail, GLenum depthFail, GLenum depthPass) { shared().stencilOp(fail, depthFail, depthPass); }
+    static void APIENTRY hookStencilMask(GLuint mask) { shared().stencilMask(mask); }
+    // per face stencil state isn't filtered, it only makes the faces' state unknown
+    static void APIENTRY hookStencilFuncSeparate(GLenum face, GLenum function, GLint reference, GLuint mask)
+    {
+        RenderState &state = shared();
+        for (unsigned int i = 0; i < 2; i++)
+            if (face == (i == 0 ? GL_FRONT : GL_BACK) || face == GL_FRONT_AND_BACK)
+                state.stencilFunction[i] = state.stencilReference[i] = state.stencilValueMask[i] = UNKNOWN;
+        state.counters.issued[STENCIL]++;
+        state.real.stencilFuncSeparate(face, function, reference, mask);
+    }
+    static void APIENTRY hookStencilOpSeparate(GLenum face, GLenum fail, GLenum depthFail, GLenum depthPass)
+    {
+        RenderState &state = shared();
+        for (unsigned int i = 0; i < 2; i++)
+            if (face == (i == 0 ? GL_FRONT : GL_BACK) || face == GL_FRONT_AND_BACK)
+                state.stencilFail[i] = state.stencilDepthFail[i] = state.stencilDepthPass[i] = UNKNOWN;
+        state.counters.issued[STENCIL]++;
+        state.real.stencilOpSeparate(face, fail, depthFail, depthPass);
+    }
+    static void APIENTRY hookStencilMaskSeparate(GLenum face, GLuint mask)
+    {
+        RenderState &state = shared();
+        for (unsigned int i = 0; i < 2; i++)
+            if (face == (i == 0 ? GL_FRONT : GL_BACK) || face == GL_FRONT_AND_BACK)
+                state.stencilWriteMask[i] = UNKNOWN;
+        state.counters.issued[STENCIL]++;
+        state.real.stencilMaskSeparate(face, mask);
+    }
+    // a deleted program stays in use until another one is, but its name may be handed out again right away
+    static void APIENTRY hookDeleteProgram(GLuint id)
+    {
+        RenderState &state = shared();
+        if (id != 0 && state.program == id)
+            state.program = UNKNOWN;
+        state.real.deleteProgram(id);
+    }
+    static void APIENTRY hookDeleteVertexArrays(GLsizei count, const GLuint *ids)
+    {
+        RenderState &state = shared();
+        state.deleted(state.vertexArray, count, ids);
+        state.real.deleteVertexArrays(count, ids);
+    }
+    static void APIENTRY hookDeleteTextures(GLsizei count, const GLuint *ids)
+    {
+        RenderState &state = shared();
+        for (unsigned int i = 0; i < TRACKED_UNITS; i++)
+            for (unsigned int j = 0; j < TRACKED_TARGETS; j++)
+                state.deleted(state.textures[i][j], count, ids);
+        state.real.deleteTextures(count, ids);
+    }
+    static void APIENTRY hookDeleteFramebuffers(GLsizei count, const GLuint *ids)
+    {
+        RenderState &state = shared();
+        state.deleted(state.drawFramebuffer, count, ids);
+        state.deleted(state.readFramebuffer, count, ids);
+        state.real.deleteFramebuffers(count, ids);
+    }
+};
+#endif
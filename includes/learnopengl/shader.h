@@ -4,167 +4,509 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/render_state.h>
+#include <learnopengl/program_cache.h>
+#include <learnopengl/shader_preprocessor.h>
+#include <learnopengl/frame_data.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
 
 class Shader
 {
 public:
     unsigned int ID;
+    // an active uniform as reported by the driver after linking; array uniforms get one entry per element
+    struct Uniform
+    {
+        std::string name;
+        GLint location;
+        GLenum type;
+        GLint size;
+        // last value uploaded through the set* functions (large enough for a mat4)
+        float value[16];
+        bool cached;
+    };
+    // index into the uniform table, resolve once with uniformHandle() and reuse it in hot loops
+    struct UniformHandle
+    {
+        int index;
+        UniformHandle(int index = -1) : index(index) {}
+        bool valid() const { return index >= 0; }
+    };
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+        : Shader(vertexPath, fragmentPath, ShaderDefines(), geometryPath)
     {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
-            {
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch (std::ifstream::failure e)
-        {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-        }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
-        {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
-        }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+    }
+    // the same shader specialized by defines, inserted after #version (see shader_preprocessor.h). Every combination
+    // of files and defines is compiled once per process, constructing it again shares the program and its uniforms.
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines &defines, const char* geometryPath = nullptr)
+    {
+        std::vector<std::pair<GLenum, std::string> > stages;
+        stages.push_back(std::make_pair((GLenum)GL_VERTEX_SHADER, std::string(vertexPath)));
+        stages.push_back(std::make_pair((GLenum)GL_FRAGMENT_SHADER, std::string(fragmentPath)));
         if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+            stages.push_back(std::make_pair((GLenum)GL_GEOMETRY_SHADER, std::string(geometryPath)));
+        build(stages, defines, true);
+    }
+    // compute shader program, requires OpenGL 4.3
+    // ------------------------------------------------------------------------
+    explicit Shader(const char* computePath, const ShaderDefines &defines = ShaderDefines())
+    {
+        std::vector<std::pair<GLenum, std::string> > stages;
+        stages.push_back(std::make_pair((GLenum)GL_COMPUTE_SHADER, std::string(computePath)));
+        build(stages, defines, true);
+    }
+    // number of distinct programs (file and define combinations) built so far
+    static unsigned int permutationCount()
+    {
+        return (unsigned int)permutations().size();
     }
-    // activate the shader
+    // whether the program is linked and its uniforms are known. Shaders from a ShaderBatch may still be compiling:
+    // with GL_KHR_parallel_shader_compile this asks the driver without waiting for it, without the extension a
+    // pending shader stays not ready until ShaderBatch::poll() or wait() finishes it.
     // ------------------------------------------------------------------------
-    void use() 
+    bool ready() const
+    {
+        if (!compiling())
+            return true;
+        if (!GLAD_GL_KHR_parallel_shader_compile)
+            return false;
+        GLint complete = GL_FALSE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &complete);
+        if (!complete)
+            return false;
+        finish();
+        return true;
+    }
+    // blocks until the program is built; use() and the uniform functions do this themselves
+    void wait() const
+    {
+        if (compiling())
+            finish();
+    }
+    // activate the shader (skipped if it already is, the first call sets up the render state tracker)
+    // ------------------------------------------------------------------------
+    void use() const
     { 
-        glUseProgram(ID); 
+        wait();
+        RenderState::shared().useProgram(ID); 
+    }
+    // uniform reflection
+    // ------------------------------------------------------------------------
+    UniformHandle uniformHandle(const std::string &name) const
+    {
+        wait();
+        std::unordered_map<std::string, int>::const_iterator it = uniforms->lookup.find(name);
+        return it != uniforms->lookup.end() ? UniformHandle(it->second) : UniformHandle();
+    }
+    GLint uniformLocation(UniformHandle handle) const
+    {
+        return known(handle) ? uniforms->entries[handle.index].location : -1;
+    }
+    const std::vector<Uniform> &activeUniforms() const
+    {
+        wait();
+        return uniforms->entries;
+    }
+    // forget all cached values; call this after uploading uniforms of this program with raw glUniform* calls
+    void invalidateUniformCache() const
+    {
+        for (unsigned int i = 0; i < uniforms->entries.size(); i++)
+            uniforms->entries[i].cached = false;
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        setBool(uniformHandle(name), value);
+    }
+    void setBool(UniformHandle handle, bool value) const
+    {
+        setInt(handle, (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        setInt(uniformHandle(name), value);
+    }
+    void setInt(UniformHandle handle, int value) const
+    {
+        if (storeValue(handle, &value, sizeof(value)))
+            glUniform1i(uniformLocation(handle), value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        setFloat(uniformHandle(name), value);
+    }
+    void setFloat(UniformHandle handle, float value) const
+    {
+        if (storeValue(handle, &value, sizeof(value)))
+            glUniform1f(uniformLocation(handle), value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec2(uniformHandle(name), value);
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        setVec2(uniformHandle(name), glm::vec2(x, y));
+    }
+    void setVec2(UniformHandle handle, const glm::vec2 &value) const
+    {
+        if (storeValue(handle, &value[0], sizeof(value)))
+            glUniform2fv(uniformLocation(handle), 1, &value[0]);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec3(uniformHandle(name), value);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        setVec3(uniformHandle(name), glm::vec3(x, y, z));
+    }
+    void setVec3(UniformHandle handle, const glm::vec3 &value) const
+    {
+        if (storeValue(handle, &value[0], sizeof(value)))
+            glUniform3fv(uniformLocation(handle), 1, &value[0]);
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec4(uniformHandle(name), value);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    void setVec4(const std::string &name, float x, float y, float z, float w) const
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        setVec4(uniformHandle(name), glm::vec4(x, y, z, w));
+    }
+    void setVec4(UniformHandle handle, const glm::vec4 &value) const
+    {
+        if (storeValue(handle, &value[0], sizeof(value)))
+            glUniform4fv(uniformLocation(handle), 1, &value[0]);
+    }
+    // ------------------------------------------------------------------------
+    void setUVec3(const std::string &name, const glm::uvec3 &value) const
+    {
+        setUVec3(uniformHandle(name), value);
+    }
+    void setUVec3(UniformHandle handle, const glm::uvec3 &value) const
+    {
+        if (storeValue(handle, &value[0], sizeof(value)))
+            glUniform3uiv(uniformLocation(handle), 1, &value[0]);
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(uniformHandle(name), mat);
+    }
+    void setMat2(UniformHandle handle, const glm::mat2 &mat) const
+    {
+        if (storeValue(handle, &mat[0][0], sizeof(mat)))
+            glUniformMatrix2fv(uniformLocation(handle), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(uniformHandle(name), mat);
+    }
+    void setMat3(UniformHandle handle, const glm::mat3 &mat) const
+    {
+        if (storeValue(handle, &mat[0][0], sizeof(mat)))
+            glUniformMatrix3fv(uniformLocation(handle), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat4(uniformHandle(name), mat);
+    }
+    void setMat4(UniformHandle handle, const glm::mat4 &mat) const
+    {
+        if (storeValue(handle, &mat[0][0], sizeof(mat)))
+            glUniformMatrix4fv(uniformLocation(handle), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
-    // utility function for checking shader compilation/linking errors.
+    friend class ShaderBatch;
+    friend class ShaderWatcher;
+
+    // uniform table, shared between copies of the same Shader so their value caches stay consistent
+    struct UniformTable
+    {
+        std::unordered_map<std::string, int> lookup;
+        std::vector<Uniform> entries;
+    };
+    std::shared_ptr<UniformTable> uniforms;
+
+    // a program whose stages were handed to the driver but whose results weren't looked at yet, shared like the
+    // uniform table so every copy sees it finish
+    struct Compilation
+    {
+        bool done;
+        uint64_t cacheKey;
+        std::vector<GLenum> types;
+        std::vector<unsigned int> shaders;
+        std::vector<std::vector<std::string> > files;
+        // time the calling thread spent handing the program to the driver and taking it back, not counting what
+        // it did in between
+        double milliseconds;
+    };
+    std::shared_ptr<Compilation> compilation;
+
+    // a program built for one combination of stage files and defines, shared by every Shader constructed with them
+    struct Permutation
+    {
+        unsigned int ID;
+        std::shared_ptr<UniformTable> uniforms;
+        std::shared_ptr<Compilation> compilation;
+        // what it was built from, to build it again when one of the files changes
+        std::vector<std::pair<GLenum, std::string> > stages;
+        ShaderDefines defines;
+        std::vector<std::string> files;
+    };
+    static std::unordered_map<std::string, Permutation> &permutations()
+    {
+        static std::unordered_map<std::string, Permutation> programs;
+        return programs;
+    }
+
+    // a shader whose program is submitted to the driver without waiting for it, see ShaderBatch
+    Shader(const std::vector<std::pair<GLenum, std::string> > &stages, const ShaderDefines &defines, bool wait)
+    {
+        build(stages, defines, wait);
+    }
+
+    // builds the program from its stages (type, file): taken from the permutations built before, restored from the
+    // program binary cache or preprocessed, compiled and linked. Unless wait is set the compiler's results are only
+    // looked at in finish(), so the driver can work on several programs at once.
+    // ------------------------------------------------------------------------
+    void build(const std::vector<std::pair<GLenum, std::string> > &stages, const ShaderDefines &defines, bool wait)
+    {
+        addBuiltinIncludes();
+        std::string permutation;
+        for (unsigned int i = 0; i < stages.size(); i++)
+            permutation += stages[i].second + "|";
+        permutation += ShaderPreprocessor::defineBlock(defines);
+        std::unordered_map<std::string, Permutation>::iterator it = permutations().find(permutation);
+        if (it != permutations().end())
+        {
+            ID = it->second.ID;
+            uniforms = it->second.uniforms;
+            compilation = it->second.compilation;
+        }
+        else
+        {
+            // 1. retrieve the source code of every stage, with its includes resolved and the defines inserted
+            std::vector<std::string> sources(stages.size());
+            std::vector<std::vector<std::string> > files(stages.size());
+            for (unsigned int i = 0; i < stages.size(); i++)
+                ShaderPreprocessor::process(stages[i].second, defines, sources[i], files[i]);
+            // 2. restore the program from the binary cache if it was built from these sources before
+            ProgramCache &cache = ProgramCache::shared();
+            uint64_t cacheKey = cache.key(sources);
+            ID = glCreateProgram();
+            uniforms = std::make_shared<UniformTable>();
+            if (cache.load(ID, cacheKey))
+            {
+                bindUniformBlocks(ID);
+                reflectUniforms(ID, *uniforms);
+            }
+            else
+            {
+                // 3. compile shaders and link them, the results are checked in finish()
+                compilation = std::make_shared<Compilation>();
+                compilation->done = false;
+                compilation->cacheKey = cacheKey;
+                compilation->files = files;
+                std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+                for (unsigned int i = 0; i < stages.size(); i++)
+                {
+                    const char *code = sources[i].c_str();
+                    unsigned int shader = glCreateShader(stages[i].first);
+                    glShaderSource(shader, 1, &code, NULL);
+                    glCompileShader(shader);
+                    glAttachShader(ID, shader);
+                    compilation->types.push_back(stages[i].first);
+                    compilation->shaders.push_back(shader);
+                }
+                // shader Program
+                cache.prepare(ID);
+                glLinkProgram(ID);
+                compilation->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+            }
+            Permutation &entry = permutations()[permutation];
+            entry.ID = ID;
+            entry.uniforms = uniforms;
+            entry.compilation = compilation;
+            entry.stages = stages;
+            entry.defines = defines;
+            entry.files = dependencies(files);
+        }
+        if (wait)
+            this->wait();
+    }
+    // every file of the stages' source strings, each once
+    static std::vector<std::string> dependencies(const std::vector<std::vector<std::string> > &files)
+    {
+        std::vector<std::string> all;
+        for (unsigned int i = 0; i < files.size(); i++)
+        {
+            for (unsigned int j = 0; j < files[i].size(); j++)
+            {
+                if (std::find(all.begin(), all.end(), files[i][j]) == all.end())
+                    all.push_back(files[i][j]);
+            }
+        }
+        return all;
+    }
+    bool compiling() const
+    {
+        return compilation && !compilation->done;
+    }
+    // reports the compiler's and linker's errors, stores the program in the binary cache and reflects its uniforms;
+    // waits for the driver if it isn't done yet
+    // ------------------------------------------------------------------------
+    void finish() const
+    {
+        Compilation &pending = *compilation;
+        std::chrono::steady_clock::time_point finishStart = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < pending.shaders.size(); i++)
+            checkCompileErrors(pending.shaders[i], stageName(pending.types[i]), &pending.files[i]);
+        checkCompileErrors(ID, "PROGRAM");
+        pending.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - finishStart).count();
+        ProgramCache::shared().store(ID, pending.cacheKey, pending.milliseconds);
+        // delete the shaders as they're linked into our program now and no longer necessery
+        for (unsigned int i = 0; i < pending.shaders.size(); i++)
+            glDeleteShader(pending.shaders[i]);
+        pending.shaders.clear();
+        pending.files.clear();
+        pending.done = true;
+        bindUniformBlocks(ID);
+        reflectUniforms(ID, *uniforms);
+    }
+    // the snippets the headers provide to every shader, see ShaderPreprocessor::addInclude()
+    static void addBuiltinIncludes()
+    {
+        static bool added = false;
+        if (added)
+            return;
+        ShaderPreprocessor::addInclude("frame_data.glsl", FrameData::glsl());
+        added = true;
+    }
+    // points the blocks every program shares at their buffers; linking resets the bindings, so this follows every link
+    static void bindUniformBlocks(GLuint program)
+    {
+        GLuint frameData = glGetUniformBlockIndex(program, "FrameData");
+        if (frameData != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, frameData, FRAME_DATA_BINDING);
+    }
+    static std::string stageName(GLenum type)
+    {
+        switch (type)
+        {
+            case GL_VERTEX_SHADER: return "VERTEX";
+            case GL_FRAGMENT_SHADER: return "FRAGMENT";
+            case GL_GEOMETRY_SHADER: return "GEOMETRY";
+            case GL_COMPUTE_SHADER: return "COMPUTE";
+        }
+        return "UNKNOWN";
+    }
+
+    // queries all active uniforms once after linking and builds the name -> uniform table.
+    // an array 'a' of size N is registered as 'a', 'a[0]' ... 'a[N-1]' so every element has its own entry.
+    // Called again after a program is relinked (see ShaderWatcher), known names keep their entry so handles stay
+    // valid; uniforms the program no longer has keep theirs with location -1.
+    // ------------------------------------------------------------------------
+    static void reflectUniforms(GLuint program, UniformTable &table)
+    {
+        for (unsigned int i = 0; i < table.entries.size(); i++)
+            table.entries[i].location = -1;
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(program, (GLuint)i, (GLsizei)buffer.size(), NULL, &size, &type, &buffer[0]);
+            std::string name(&buffer[0]);
+            // uniforms inside uniform blocks have no location and are set through buffers instead
+            if (glGetUniformLocation(program, name.c_str()) < 0)
+                continue;
+            std::string::size_type bracket = name.rfind("[0]");
+            if (size > 1 && bracket != std::string::npos && bracket + 3 == name.size())
+            {
+                std::string base = name.substr(0, bracket);
+                for (GLint element = 0; element < size; element++)
+                    addUniform(program, table, base + "[" + std::to_string(element) + "]", type, 1);
+                table.lookup[base] = table.lookup[name];
+            }
+            else
+            {
+                addUniform(program, table, name, type, size);
+                // single element arrays are reported as 'a[0]', also make them reachable as 'a'
+                if (bracket != std::string::npos && bracket + 3 == name.size())
+                    table.lookup[name.substr(0, bracket)] = table.lookup[name];
+            }
+        }
+    }
+    static void addUniform(GLuint program, UniformTable &table, const std::string &name, GLenum type, GLint size)
+    {
+        std::unordered_map<std::string, int>::iterator it = table.lookup.find(name);
+        if (it != table.lookup.end())
+        {
+            Uniform &uniform = table.entries[it->second];
+            uniform.location = glGetUniformLocation(program, name.c_str());
+            // a value of another type can't be uploaded again
+            uniform.cached = uniform.cached && uniform.type == type;
+            uniform.type = type;
+            uniform.size = size;
+            return;
+        }
+        Uniform uniform;
+        uniform.name = name;
+        uniform.location = glGetUniformLocation(program, name.c_str());
+        uniform.type = type;
+        uniform.size = size;
+        uniform.cached = false;
+        table.lookup[name] = (int)table.entries.size();
+        table.entries.push_back(uniform);
+    }
+    // whether handle indexes this program's uniform table; one from another program may point past its end
+    bool known(UniformHandle handle) const
+    {
+        return handle.valid() && (size_t)handle.index < uniforms->entries.size();
+    }
+    // records a value about to be uploaded; returns false if the uniform is unknown or already holds this value
+    bool storeValue(UniformHandle handle, const void *data, size_t bytes) const
+    {
+        if (!known(handle))
+            return false;
+        Uniform &uniform = uniforms->entries[handle.index];
+        if (uniform.cached && std::memcmp(uniform.value, data, bytes) == 0)
+            return false;
+        std::memcpy(uniform.value, data, bytes);
+        uniform.cached = true;
+        return true;
+    }
+    // utility function for checking shader compilation/linking errors; files lists the shader's source strings the
+    // line numbers in the log refer to, as numbered by ShaderPreprocessor.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    static void checkCompileErrors(GLuint shader, std::string type, const std::vector<std::string> *files = nullptr)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -174,7 +516,10 @@ private:
             if(!success)
             {
                 glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog;
+                for (unsigned int i = 0; files != nullptr && i < files->size(); i++)
+                    std::cout << "source string " << i << ": " << (*files)[i] << "\n";
+                std::cout << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
         else
@@ -0,0 +1,108 @@
+#ifndef SHADER_BATCH_H
+#define SHADER_BATCH_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+
+#include <vector>
+
+// Compiles many shaders at once: add() hands every program to the driver right away and returns its Shader without
+// waiting for the compiler, so a driver with GL_KHR_parallel_shader_compile builds them on its own threads while the
+// demo goes on loading textures, uploading meshes or rendering with programs that are already done. A batch goes
+//     ShaderBatch batch;
+//     Shader lighting = batch.add("lighting.vs", "lighting.fs");   ... all the other programs
+//     if (lighting.ready()) lighting.use(); else fallback.use();   each frame, or
+//     batch.poll();                                                  to finish whatever the driver completed
+// A shader that's used (or whose uniforms are set) before it's ready waits for its program, so skipping the checks
+// still works, it just doesn't overlap anything. Programs restored from the binary cache are ready immediately.
+// Without the extension the driver compiles on the calling thread and there is no way to ask whether it's done
+// without waiting, so poll() finishes one program per call and the wait is spread over that many frames.
+// ------------------------------------------------------------------------------------------------------
+class ShaderBatch
+{
+public:
+    ShaderBatch()
+    {
+        // let the driver use as many compiler threads as it likes
+        if (GLAD_GL_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+
+    // whether the driver compiles in the background
+    static bool parallel()
+    {
+        return GLAD_GL_KHR_parallel_shader_compile != 0;
+    }
+
+    Shader add(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    {
+        return add(vertexPath, fragmentPath, ShaderDefines(), geometryPath);
+    }
+    Shader add(const char* vertexPath, const char* fragmentPath, const ShaderDefines &defines, const char* geometryPath = nullptr)
+    {
+        std::vector<std::pair<GLenum, std::string> > stages;
+        stages.push_back(std::make_pair((GLenum)GL_VERTEX_SHADER, std::string(vertexPath)));
+        stages.push_back(std::make_pair((GLenum)GL_FRAGMENT_SHADER, std::string(fragmentPath)));
+        if (geometryPath != nullptr)
+            stages.push_back(std::make_pair((GLenum)GL_GEOMETRY_SHADER, std::string(geometryPath)));
+        return submit(stages, defines);
+    }
+    Shader addCompute(const char* computePath, const ShaderDefines &defines = ShaderDefines())
+    {
+        std::vector<std::pair<GLenum, std::string> > stages;
+        stages.push_back(std::make_pair((GLenum)GL_COMPUTE_SHADER, std::string(computePath)));
+        return submit(stages, defines);
+    }
+
+    // finishes the programs the driver is done with without waiting for the others; returns how many are left
+    unsigned int poll()
+    {
+        bool finishedOne = false;
+        unsigned int left = 0;
+        for (unsigned int i = 0; i < shaders.size(); i++)
+        {
+            if (shaders[i].ready())
+                continue;
+            if (!parallel() && !finishedOne)
+            {
+                shaders[i].wait();
+                finishedOne = true;
+                continue;
+            }
+            left++;
+        }
+        return left;
+    }
+
+    // finishes every program, waiting for the driver where it has to
+    void wait()
+    {
+        for (unsigned int i = 0; i < shaders.size(); i++)
+            shaders[i].wait();
+    }
+
+    // whether every program added so far is ready, without waiting
+    bool ready() const
+    {
+        for (unsigned int i = 0; i < shaders.size(); i++)
+        {
+            if (!shaders[i].ready())
+                return false;
+        }
+        return true;
+    }
+
+    unsigned int size() const { return (unsigned int)shaders.size(); }
+
+private:
+    std::vector<Shader> shaders;
+
+    Shader submit(const std::vector<std::pair<GLenum, std::string> > &stages, const ShaderDefines &defines)
+    {
+        Shader shader(stages, defines, false);
+        shaders.push_back(shader);
+        return shader;
+    }
+};
+#endif
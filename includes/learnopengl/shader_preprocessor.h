@@ -0,0 +1,152 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// preprocessor symbols handed to a shader, name -> value (an empty value just defines the name)
+typedef std::map<std::string, std::string> ShaderDefines;
+
+// Expands a GLSL file before it goes to glShaderSource:
+//  - '#include "file"' (or <file>) lines are replaced by that file, looked up next to the including file first and
+//    then relative to the working directory. Every file is included at most once per shader, like #pragma once, so
+//    shared snippets need no include guards and include cycles end.
+//  - the defines are inserted as '#define NAME VALUE' lines right after #version, so a shader can use them like any
+//    other constant, e.g. to size its arrays or unroll its loops.
+// '#line' directives keep the driver's error messages pointing at the right line: source string 0 is the file itself
+// and the included files are numbered in the order they appear, as listed in files.
+// An include no file is found for can come from addInclude(), for snippets that belong to a header rather than to
+// a demo (e.g. frame_data.glsl, see frame_data.h).
+// ------------------------------------------------------------------------------------------------------
+class ShaderPreprocessor
+{
+public:
+    // reads path and returns its expanded source in code; files receives path and every file it included.
+    // Returns false, printing the reason, when a file can't be read.
+    static bool process(const std::string &path, const ShaderDefines &defines, std::string &code, std::vector<std::string> &files)
+    {
+        files.clear();
+        std::set<std::string> included;
+        std::ostringstream out;
+        if (!expand(path, defines, out, files, included))
+            return false;
+        code = out.str();
+        return true;
+    }
+
+    // makes '#include "name"' insert source wherever there's no file called name
+    static void addInclude(const std::string &name, const std::string &source)
+    {
+        builtins()[name] = source;
+    }
+
+    // the defines as the text inserted after #version, also handy as a cache key
+    static std::string defineBlock(const ShaderDefines &defines)
+    {
+        std::string block;
+        for (ShaderDefines::const_iterator it = defines.begin(); it != defines.end(); ++it)
+            block += "#define " + it->first + (it->second.empty() ? "" : " " + it->second) + "\n";
+        return block;
+    }
+
+private:
+    static std::map<std::string, std::string> &builtins()
+    {
+        static std::map<std::string, std::string> sources;
+        return sources;
+    }
+
+    static bool readFile(const std::string &path, std::string &text)
+    {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file)
+            return false;
+        std::stringstream stream;
+        stream << file.rdbuf();
+        text = stream.str();
+        return true;
+    }
+
+    static std::string directoryOf(const std::string &path)
+    {
+        std::string::size_type slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    }
+
+    // the file name of an '#include' line, or an empty string if line isn't one
+    static std::string includeName(const std::string &line)
+    {
+        std::string::size_type start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 1, "#") != 0)
+            return "";
+        start = line.find_first_not_of(" \t", start + 1);
+        if (start == std::string::npos || line.compare(start, 7, "include") != 0)
+            return "";
+        start = line.find_first_of("\"<", start + 7);
+        if (start == std::string::npos)
+            return "";
+        std::string::size_type end = line.find_first_of(line[start] == '"' ? "\"" : ">", start + 1);
+        return end == std::string::npos ? "" : line.substr(start + 1, end - start - 1);
+    }
+
+    static bool isVersion(const std::string &line)
+    {
+        std::string::size_type start = line.find_first_not_of(" \t");
+        return start != std::string::npos && line.compare(start, 8, "#version") == 0;
+    }
+
+    static bool expand(const std::string &path, const ShaderDefines &defines, std::ostringstream &out, std::vector<std::string> &files,
+                       std::set<std::string> &included)
+    {
+        std::string text;
+        if (!readFile(path, text))
+        {
+            std::map<std::string, std::string>::const_iterator builtin = builtins().find(path);
+            if (builtin == builtins().end())
+            {
+                std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+                return false;
+            }
+            text = builtin->second;
+        }
+        included.insert(path);
+        const unsigned int sourceIndex = (unsigned int)files.size();
+        files.push_back(path);
+
+        std::istringstream lines(text);
+        std::string line;
+        unsigned int lineNumber = 0;
+        while (std::getline(lines, line))
+        {
+            lineNumber++;
+            std::string name = includeName(line);
+            if (!name.empty())
+            {
+                std::string resolved = directoryOf(path) + name;
+                if (!std::ifstream(resolved.c_str()))
+                    resolved = name;
+                if (included.count(resolved) == 0)
+                {
+                    out << "#line 1 " << files.size() << "\n";
+                    if (!expand(resolved, ShaderDefines(), out, files, included))
+                    {
+                        std::cout << "ERROR::SHADER::INCLUDE_FAILED in " << path << "(" << lineNumber << ")" << std::endl;
+                        return false;
+                    }
+                }
+                out << "#line " << lineNumber + 1 << " " << sourceIndex << "\n";
+                continue;
+            }
+            out << line << "\n";
+            if (sourceIndex == 0 && !defines.empty() && isVersion(line))
+                out << defineBlock(defines) << "#line " << lineNumber + 1 << " 0\n";
+        }
+        return true;
+    }
+};
+#endif
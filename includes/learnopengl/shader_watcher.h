@@ -0,0 +1,416 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/render_state.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <climits>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Shader hot reloading: watches the files of every program Shader built (its stages and everything they #include)
+// and rebuilds the programs whose files change while the demo runs. Call update() once per frame, between frames:
+//  1. it picks up the files saved since the last call, through inotify on Linux and by polling their modification
+//     times twice a second elsewhere;
+//  2. preprocesses, compiles and links the new sources into a separate program, which the driver builds in the
+//     background if it supports GL_KHR_parallel_shader_compile;
+//  3. once that program is done and linked without errors, copies its binary into the program the Shaders use, so
+//     nothing is linked again on this thread and the name stays the same: every copy of the Shader, and everything
+//     that stored the name, picks the new version up. Contexts before OpenGL 4.1, which made program binaries core
+//     (glad isn't generated with ARB_get_program_binary, so older contexts with the extension don't count), link
+//     the new shaders into it instead. Uniform handles stay valid and the values set through the Shader are
+//     uploaded again.
+// A program whose new sources don't compile or link reports the errors and keeps running the previous version.
+// Demos load their shaders from the build directory, where CMake copies them; configure with -DSHADER_LINKS=ON to
+// link them to the sources instead, so editing the files in src/ reloads them.
+// ------------------------------------------------------------------------------------------------------
+class ShaderWatcher
+{
+public:
+    // set to false to stop picking up changes
+    bool enabled;
+    // programs swapped for their new version and reloads that failed and kept the previous one
+    unsigned int reloads;
+    unsigned int failures;
+
+    static ShaderWatcher &shared()
+    {
+        static ShaderWatcher watcher;
+        return watcher;
+    }
+
+    ShaderWatcher() : enabled(true), reloads(0), failures(0), notifier(-1), knownPermutations(0), dependenciesChanged(false)
+    {
+#ifdef __linux__
+        notifier = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+        lastScan = std::chrono::steady_clock::now();
+    }
+    ~ShaderWatcher()
+    {
+#ifdef __linux__
+        if (notifier >= 0)
+            close(notifier);
+#endif
+    }
+
+    void update()
+    {
+        if (!enabled)
+            return;
+        watchNewFiles();
+        collectChanges();
+        // rebuild the changed programs, except those still being built for the first time (see ShaderBatch)
+        for (std::set<std::string>::iterator it = changed.begin(); it != changed.end();)
+        {
+            Shader::Permutation &program = Shader::permutations()[*it];
+            if (program.compilation && !program.compilation->done)
+            {
+                ++it;
+                continue;
+            }
+            start(*it);
+            changed.erase(it++);
+        }
+        // swap in the rebuilt programs the driver is done with
+        for (unsigned int i = 0; i < pending.size();)
+        {
+            if (!complete(pending[i]))
+            {
+                i++;
+                continue;
+            }
+            finish(pending[i]);
+            pending.erase(pending.begin() + i);
+        }
+    }
+
+private:
+    // a program's new version, built on its own until it's known to work
+    struct Reload
+    {
+        std::string permutation;
+        GLuint program;
+        std::vector<GLenum> types;
+        std::vector<GLuint> shaders;
+        std::vector<std::vector<std::string> > files;
+        uint64_t cacheKey;
+        double milliseconds;
+    };
+
+    int notifier;
+    std::map<int, std::string> watches;                           // inotify watch -> directory
+    std::map<std::string, std::vector<std::string> > dependents;  // real path of a file -> permutations built from it
+    std::map<std::string, time_t> modified;                       // real path of a file -> modification time, when polling
+    unsigned int knownPermutations;
+    bool dependenciesChanged;
+    std::set<std::string> changed;
+    std::vector<Reload> pending;
+    std::chrono::steady_clock::time_point lastScan;
+
+    // maps the files of every program built so far to their programs, when there are new programs or a reload
+    // changed what a program includes
+    void watchNewFiles()
+    {
+        if (Shader::permutationCount() == knownPermutations && !dependenciesChanged)
+            return;
+        knownPermutations = Shader::permutationCount();
+        dependenciesChanged = false;
+        dependents.clear();
+        std::unordered_map<std::string, Shader::Permutation> &programs = Shader::permutations();
+        for (std::unordered_map<std::string, Shader::Permutation>::iterator it = programs.begin(); it != programs.end(); ++it)
+        {
+            for (unsigned int i = 0; i < it->second.files.size(); i++)
+            {
+                // files are watched where they really are, so a shader linked into the build directory is watched in src/
+                std::string file = realPath(it->second.files[i]);
+                if (file.empty())
+                    continue;
+                dependents[file].push_back(it->first);
+                std::string::size_type slash = file.find_last_of("/\\");
+                watch(slash == std::string::npos ? "." : file.substr(0, slash));
+                if (notifier < 0 && modified.count(file) == 0)
+                    modified[file] = modificationTime(file);
+            }
+        }
+    }
+
+    void watch(const std::string &directory)
+    {
+#ifdef __linux__
+        if (notifier < 0)
+            return;
+        for (std::map<int, std::string>::iterator it = watches.begin(); it != watches.end(); ++it)
+        {
+            if (it->second == directory)
+                return;
+        }
+        // editors either write the file in place or write a new one and rename it over the old one
+        int watch = inotify_add_watch(notifier, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch >= 0)
+            watches[watch] = directory;
+#else
+        (void)directory;
+#endif
+    }
+
+    void collectChanges()
+    {
+#ifdef __linux__
+        if (notifier >= 0)
+        {
+            char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            ssize_t length;
+            while ((length = read(notifier, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *event = buffer; event < buffer + length; event += sizeof(struct inotify_event) + ((struct inotify_event*)event)->len)
+                {
+                    struct inotify_event *notification = (struct inotify_event*)event;
+                    if (notification->len > 0 && watches.count(notification->wd))
+                        fileChanged(watches[notification->wd] + "/" + notification->name);
+                }
+            }
+            return;
+        }
+#endif
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - lastScan < std::chrono::milliseconds(500))
+            return;
+        lastScan = now;
+        for (std::map<std::string, time_t>::iterator it = modified.begin(); it != modified.end(); ++it)
+        {
+            time_t time = modificationTime(it->first);
+            if (time != it->second)
+            {
+                it->second = time;
+                fileChanged(it->first);
+            }
+        }
+    }
+
+    void fileChanged(const std::string &file)
+    {
+        std::map<std::string, std::vector<std::string> >::iterator it = dependents.find(file);
+        if (it != dependents.end())
+            changed.insert(it->second.begin(), it->second.end());
+    }
+
+    // hands the program's current sources to the driver, linked into a program of their own
+    void start(const std::string &permutation)
+    {
+        Shader::Permutation &program = Shader::permutations()[permutation];
+        Reload reload;
+        reload.permutation = permutation;
+        std::vector<std::string> sources(program.stages.size());
+        reload.files.resize(program.stages.size());
+        for (unsigned int i = 0; i < program.stages.size(); i++)
+        {
+            if (!ShaderPreprocessor::process(program.stages[i].second, program.defines, sources[i], reload.files[i]))
+            {
+                failures++;
+                std::cout << "ERROR::SHADER::RELOAD_FAILED, keeping the previous version of " << describe(program) << std::endl;
+                return;
+            }
+        }
+        // a newer change replaces a reload that's still being built
+        for (unsigned int i = 0; i < pending.size(); i++)
+        {
+            if (pending[i].permutation == permutation)
+            {
+                discard(pending[i]);
+                pending.erase(pending.begin() + i);
+                break;
+            }
+        }
+        std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+        reload.cacheKey = ProgramCache::shared().key(sources);
+        reload.program = glCreateProgram();
+        for (unsigned int i = 0; i < program.stages.size(); i++)
+        {
+            const char *code = sources[i].c_str();
+            GLuint shader = glCreateShader(program.stages[i].first);
+            glShaderSource(shader, 1, &code, NULL);
+            glCompileShader(shader);
+            glAttachShader(reload.program, shader);
+            reload.types.push_back(program.stages[i].first);
+            reload.shaders.push_back(shader);
+        }
+        // keeps the binary retrievable for the swap in finish()
+        if (GLAD_GL_VERSION_4_1)
+            glProgramParameteri(reload.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(reload.program);
+        reload.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+        pending.push_back(reload);
+    }
+
+    // whether the driver is done with the reload; without GL_KHR_parallel_shader_compile finish() waits for it
+    static bool complete(const Reload &reload)
+    {
+        if (!GLAD_GL_KHR_parallel_shader_compile)
+            return true;
+        GLint complete = GL_FALSE;
+        glGetProgramiv(reload.program, GL_COMPLETION_STATUS_KHR, &complete);
+        return complete == GL_TRUE;
+    }
+
+    void finish(Reload &reload)
+    {
+        Shader::Permutation &program = Shader::permutations()[reload.permutation];
+        std::chrono::steady_clock::time_point finishStart = std::chrono::steady_clock::now();
+        bool compiled = true;
+        for (unsigned int i = 0; i < reload.shaders.size(); i++)
+        {
+            GLint success = GL_FALSE;
+            glGetShaderiv(reload.shaders[i], GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                Shader::checkCompileErrors(reload.shaders[i], Shader::stageName(reload.types[i]), &reload.files[i]);
+                compiled = false;
+            }
+        }
+        GLint linked = GL_FALSE;
+        glGetProgramiv(reload.program, GL_LINK_STATUS, &linked);
+        if (compiled && !linked)
+            Shader::checkCompileErrors(reload.program, "PROGRAM");
+        if (!compiled || !linked)
+        {
+            failures++;
+            std::cout << "ERROR::SHADER::RELOAD_FAILED, keeping the previous version of " << describe(program) << std::endl;
+            discard(reload);
+            return;
+        }
+
+        reload.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - finishStart).count();
+        ProgramCache::shared().store(reload.program, reload.cacheKey, reload.milliseconds);
+
+        // the new version works: move it into the program in use in place of the old one
+        GLuint attached[8];
+        GLsizei count = 0;
+        glGetAttachedShaders(program.ID, 8, &count, attached);
+        for (GLsizei i = 0; i < count; i++)
+            glDetachShader(program.ID, attached[i]);
+        if (!copyBinary(reload.program, program.ID))
+        {
+            for (unsigned int i = 0; i < reload.shaders.size(); i++)
+                glAttachShader(program.ID, reload.shaders[i]);
+            glLinkProgram(program.ID);
+            Shader::checkCompileErrors(program.ID, "PROGRAM");
+        }
+
+        Shader::bindUniformBlocks(program.ID);
+        Shader::reflectUniforms(program.ID, *program.uniforms);
+        restoreUniforms(program);
+        program.files = Shader::dependencies(reload.files);
+        dependenciesChanged = true;
+        reloads++;
+        std::cout << "reloaded " << describe(program) << std::endl;
+        discard(reload);
+    }
+
+    // copies the executable of the linked program 'from' into 'to'; false if the driver can't, 'to' is then unlinked
+    static bool copyBinary(GLuint from, GLuint to)
+    {
+        if (!GLAD_GL_VERSION_4_1)
+            return false;
+        GLint length = 0;
+        glGetProgramiv(from, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return false;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        GLsizei written = 0;
+        glGetProgramBinary(from, length, &written, &format, &binary[0]);
+        if (written <= 0)
+            return false;
+        glProgramBinary(to, format, &binary[0], written);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(to, GL_LINK_STATUS, &linked);
+        return linked == GL_TRUE;
+    }
+
+    // the new version starts with default uniform values, uploads the values last set through the Shader again
+    static void restoreUniforms(const Shader::Permutation &program)
+    {
+        RenderState::shared().useProgram(program.ID);
+        std::vector<Shader::Uniform> &entries = program.uniforms->entries;
+        for (unsigned int i = 0; i < entries.size(); i++)
+        {
+            const Shader::Uniform &uniform = entries[i];
+            if (!uniform.cached || uniform.location < 0)
+                continue;
+            switch (uniform.type)
+            {
+                case GL_FLOAT: glUniform1fv(uniform.location, 1, uniform.value); break;
+                case GL_FLOAT_VEC2: glUniform2fv(uniform.location, 1, uniform.value); break;
+                case GL_FLOAT_VEC3: glUniform3fv(uniform.location, 1, uniform.value); break;
+                case GL_FLOAT_VEC4: glUniform4fv(uniform.location, 1, uniform.value); break;
+                case GL_FLOAT_MAT2: glUniformMatrix2fv(uniform.location, 1, GL_FALSE, uniform.value); break;
+                case GL_FLOAT_MAT3: glUniformMatrix3fv(uniform.location, 1, GL_FALSE, uniform.value); break;
+                case GL_FLOAT_MAT4: glUniformMatrix4fv(uniform.location, 1, GL_FALSE, uniform.value); break;
+                case GL_UNSIGNED_INT_VEC3:
+                {
+                    GLuint value[3];
+                    std::memcpy(value, uniform.value, sizeof(value));
+                    glUniform3uiv(uniform.location, 1, value);
+                    break;
+                }
+                default:
+                {
+                    // ints, bools and samplers, all set through setInt()
+                    int value;
+                    std::memcpy(&value, uniform.value, sizeof(value));
+                    glUniform1i(uniform.location, value);
+                }
+            }
+        }
+    }
+
+    static void discard(Reload &reload)
+    {
+        for (unsigned int i = 0; i < reload.shaders.size(); i++)
+            glDeleteShader(reload.shaders[i]);
+        glDeleteProgram(reload.program);
+    }
+
+    static std::string describe(const Shader::Permutation &program)
+    {
+        std::string files;
+        for (unsigned int i = 0; i < program.stages.size(); i++)
+            files += (i > 0 ? ", " : "") + program.stages[i].second;
+        return files;
+    }
+
+    static std::string realPath(const std::string &path)
+    {
+#ifdef _WIN32
+        char resolved[_MAX_PATH];
+        return _fullpath(resolved, path.c_str(), _MAX_PATH) ? std::string(resolved) : std::string();
+#else
+        char resolved[PATH_MAX];
+        return realpath(path.c_str(), resolved) ? std::string(resolved) : std::string();
+#endif
+    }
+
+    static time_t modificationTime(const std::string &path)
+    {
+        struct stat status;
+        return stat(path.c_str(), &status) == 0 ? status.st_mtime : 0;
+    }
+
+    ShaderWatcher(const ShaderWatcher&);
+    ShaderWatcher &operator=(const ShaderWatcher&);
+};
+#endif
@@ -0,0 +1,94 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Buffer for data the CPU rewrites every frame (e.g. per instance matrices), split into regions that are
+// written round-robin so the CPU never waits for the GPU to finish reading the previous frame's data.
+// With GL 4.4 the buffer is created with glBufferStorage and stays persistently mapped; otherwise each region
+// is mapped unsynchronized. Either way a fence per region guards against overwriting data still in use.
+// Per frame: write to map(), unmap(), draw using the data at offset(), then fence().
+// ------------------------------------------------------------------------------------------------------
+class StreamBuffer
+{
+public:
+    unsigned int ID;
+    GLenum target;
+    GLsizeiptr regionSize;
+    bool persistent; // created with glBufferStorage and mapped once
+
+    StreamBuffer(GLenum target, GLsizeiptr regionSize, unsigned int regionCount = 3)
+        : target(target), regionSize(regionSize), persistent(GLAD_GL_VERSION_4_4 != 0), fences(regionCount, (GLsync)0), region(0), mapped(NULL)
+    {
+        glGenBuffers(1, &ID);
+        glBindBuffer(target, ID);
+        GLsizeiptr size = regionSize * regionCount;
+        if (persistent)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(target, size, NULL, flags);
+            mapped = (char*)glMapBufferRange(target, 0, size, flags);
+        }
+        else
+            glBufferData(target, size, NULL, GL_STREAM_DRAW);
+    }
+    ~StreamBuffer()
+    {
+        for (unsigned int i = 0; i < fences.size(); i++)
+            if (fences[i])
+                glDeleteSync(fences[i]);
+        glBindBuffer(target, ID);
+        if (persistent)
+            glUnmapBuffer(target);
+        glDeleteBuffers(1, &ID);
+    }
+
+    // waits until the GPU is done with the current region and returns a pointer to write regionSize bytes to
+    void *map()
+    {
+        if (fences[region])
+        {
+            // usually signaled long ago, only blocks if the CPU runs regionCount frames ahead
+            while (glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+                ;
+            glDeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+        if (persistent)
+            return mapped + offset();
+        glBindBuffer(target, ID);
+        return glMapBufferRange(target, offset(), regionSize, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    }
+
+    void unmap()
+    {
+        if (persistent)
+            return; // coherent mapping, the writes are visible to the next draw
+        glBindBuffer(target, ID);
+        glUnmapBuffer(target);
+    }
+
+    // byte offset of the current region in the buffer
+    GLintptr offset() const
+    {
+        return (GLintptr)region * regionSize;
+    }
+
+    // call after the last draw reading the current region; moves on to the next region
+    void fence()
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % fences.size();
+    }
+
+private:
+    std::vector<GLsync> fences;
+    unsigned int region;
+    char *mapped;
+
+    StreamBuffer(const StreamBuffer&);
+    StreamBuffer &operator=(const StreamBuffer&);
+};
+#endif
@@ -0,0 +1,191 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/texture_loader.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cstdlib>
+#include <climits>
+
+// Process-wide, reference counted cache of 2D textures keyed by canonical file path and upload options,
+// so every Model (and demo) sharing a texture file decodes and uploads it only once.
+// acquire() hands out a reference that is given back with release(); textures without references stay
+// resident until evictUnused() deletes them.
+// ------------------------------------------------------------------------------------------------------
+class TextureCache
+{
+public:
+    struct Entry
+    {
+        unsigned int id;
+        unsigned int references;
+        bool ready;   // the loader is done with the texture (uploaded or failed)
+        size_t bytes; // estimated GPU memory including mipmaps, 0 until the texture is uploaded
+    };
+
+    static TextureCache &shared()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    TextureCache(TextureLoader &loader = TextureLoader::shared()) : loader(loader), totalBytes(0) {}
+
+    // returns the texture for the given file, queueing it on the loader on first use
+    unsigned int acquire(const std::string &path, TextureOptions options = TextureOptions())
+    {
+        std::string key = canonicalPath(path);
+        key += options.gammaCorrection ? "|srgb" : "|linear";
+        if (options.clampAlpha)
+            key += "|clamp";
+        std::unordered_map<std::string, Entry>::iterator it = entries.find(key);
+        if (it != entries.end())
+        {
+            it->second.references++;
+            return it->second.id;
+        }
+        Entry entry;
+        entry.references = 1;
+        entry.ready = false;
+        entry.bytes = 0;
+        entry.id = loader.load(path, options, std::bind(&TextureCache::loaded, this, std::placeholders::_1, std::placeholders::_2)).id;
+        entries[key] = entry;
+        keys[entry.id] = key;
+        return entry.id;
+    }
+
+    // gives back a reference obtained from acquire(); the texture stays cached until evicted
+    void release(unsigned int textureID)
+    {
+        Entry *entry = find(textureID);
+        if (entry && entry->references > 0)
+            entry->references--;
+    }
+
+    // deletes every texture that is no longer referenced and not waiting for its upload; returns the number of deleted textures
+    unsigned int evictUnused()
+    {
+        std::vector<unsigned int> unused;
+        for (std::unordered_map<std::string, Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+            if (it->second.references == 0 && it->second.ready)
+                unused.push_back(it->second.id);
+        for (unsigned int i = 0; i < unused.size(); i++)
+            evict(unused[i]);
+        return (unsigned int)unused.size();
+    }
+
+    // deletes a texture regardless of its references (it must not be waiting for its upload anymore)
+    void evict(unsigned int textureID)
+    {
+        std::unordered_map<unsigned int, std::string>::iterator key = keys.find(textureID);
+        if (key == keys.end())
+            return;
+        totalBytes -= entries[key->second].bytes;
+        entries.erase(key->second);
+        keys.erase(key);
+        glDeleteTextures(1, &textureID);
+    }
+
+    const Entry *entry(unsigned int textureID) const
+    {
+        std::unordered_map<unsigned int, std::string>::const_iterator key = keys.find(textureID);
+        return key != keys.end() ? &entries.find(key->second)->second : NULL;
+    }
+    unsigned int textureCount() const { return (unsigned int)entries.size(); }
+    size_t memoryUsage() const { return totalBytes; }
+
+    // resolves '.', '..', duplicate and back slashes so different spellings of a path share one entry
+    static std::string canonicalPath(const std::string &path)
+    {
+#ifdef _WIN32
+        char resolved[_MAX_PATH];
+        if (_fullpath(resolved, path.c_str(), _MAX_PATH) != NULL)
+            return normalizePath(resolved);
+#else
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved) != NULL)
+            return resolved;
+#endif
+        return normalizePath(path);
+    }
+
+private:
+    TextureLoader &loader;
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<unsigned int, std::string> keys; // texture ID -> key into entries
+    size_t totalBytes;
+
+    Entry *find(unsigned int textureID)
+    {
+        std::unordered_map<unsigned int, std::string>::iterator key = keys.find(textureID);
+        return key != keys.end() ? &entries[key->second] : NULL;
+    }
+
+    // loader callback, records the size of the uploaded texture
+    void loaded(unsigned int textureID, bool success)
+    {
+        Entry *entry = find(textureID);
+        if (!entry)
+            return;
+        entry->ready = true;
+        if (!success)
+            return;
+        GLint width = 0, height = 0, red = 0, green = 0, blue = 0, alpha = 0;
+        // the caller may already have bound its textures for the frame (and RenderState may remember them), so the
+        // query leaves the active unit's binding as it found it
+        GLint previous = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_RED_SIZE, &red);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_GREEN_SIZE, &green);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_BLUE_SIZE, &blue);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_ALPHA_SIZE, &alpha);
+        glBindTexture(GL_TEXTURE_2D, previous);
+        // a full mip chain adds a third on top of the base level
+        size_t base = (size_t)width * height * ((red + green + blue + alpha + 7) / 8);
+        entry->bytes = base + base / 3;
+        totalBytes += entry->bytes;
+    }
+
+    static std::string normalizePath(const std::string &path)
+    {
+        std::string unified = path;
+        for (unsigned int i = 0; i < unified.size(); i++)
+            if (unified[i] == '\\')
+                unified[i] = '/';
+        std::vector<std::string> parts;
+        std::string::size_type start = 0;
+        while (start <= unified.size())
+        {
+            std::string::size_type end = unified.find('/', start);
+            if (end == std::string::npos)
+                end = unified.size();
+            std::string part = unified.substr(start, end - start);
+            if (part == "..")
+            {
+                if (!parts.empty() && parts.back() != "..")
+                    parts.pop_back();
+                else
+                    parts.push_back(part);
+            }
+            else if (!part.empty() && part != ".")
+                parts.push_back(part);
+            start = end + 1;
+        }
+        std::string normalized = !unified.empty() && unified[0] == '/' ? "/" : "";
+        for (unsigned int i = 0; i < parts.size(); i++)
+            normalized += (i > 0 ? "/" : "") + parts[i];
+        return normalized;
+    }
+
+    TextureCache(const TextureCache&);
+    TextureCache &operator=(const TextureCache&);
+};
+#endif
@@ -0,0 +1,266 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <stb_image.h>
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+
+// how a texture should be uploaded; matches the variants of loadTexture() used throughout the demos
+struct TextureOptions
+{
+    bool gammaCorrection; // upload color textures as sRGB so they are linearized when sampled
+    bool clampAlpha;      // clamp RGBA textures to the edge to prevent semi-transparent borders
+    TextureOptions(bool gammaCorrection = false, bool clampAlpha = false) : gammaCorrection(gammaCorrection), clampAlpha(clampAlpha) {}
+};
+
+// Decodes image files with stb_image on a pool of worker threads and uploads them on the GL thread.
+// load() returns a texture name right away; until the image arrives that texture holds a 1x1 placeholder
+// so it can already be bound. Call update() once per frame (or finish() during loading screens) on the
+// thread owning the GL context to upload whatever has been decoded since.
+// Note that stbi_set_flip_vertically_on_load() is global state read while decoding, so don't change it
+// while textures are still pending.
+// ------------------------------------------------------------------------------------------------------
+class TextureLoader
+{
+public:
+    // called on the GL thread once the texture has its final contents (or failed to load)
+    typedef std::function<void(unsigned int textureID, bool success)> Callback;
+
+    struct PendingTexture
+    {
+        unsigned int id;
+        // becomes ready on the GL thread in update()/finish(); don't block on it there without pumping uploads
+        std::shared_future<bool> loaded;
+    };
+
+    // number of worker threads, 0 picks one per hardware thread
+    explicit TextureLoader(unsigned int threads = 0) : usePixelBuffers(false), stopping(false), pending(0)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threads; i++)
+            workers.push_back(std::thread(&TextureLoader::work, this));
+    }
+    ~TextureLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeWorkers.notify_all();
+        for (unsigned int i = 0; i < workers.size(); i++)
+            workers[i].join();
+        for (unsigned int i = 0; i < decoded.size(); i++)
+            stbi_image_free(decoded[i]->data);
+    }
+
+    // loader shared by Model and the demos
+    static TextureLoader &shared()
+    {
+        static TextureLoader loader;
+        return loader;
+    }
+
+    // queues a texture for loading; must be called on the GL thread
+    PendingTexture load(const std::string &path, TextureOptions options = TextureOptions(), Callback callback = Callback())
+    {
+        std::shared_ptr<Job> job = std::make_shared<Job>();
+        job->path = path;
+        job->options = options;
+        job->callback = callback;
+        job->data = NULL;
+        glGenTextures(1, &job->id);
+        uploadPlaceholder(job->id);
+
+        PendingTexture texture;
+        texture.id = job->id;
+        texture.loaded = job->promise.get_future().share();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued.push_back(job);
+            pending++;
+        }
+        wakeWorkers.notify_one();
+        return texture;
+    }
+
+    // uploads up to maxUploads decoded textures (0 uploads all of them); returns the number of uploaded textures
+    unsigned int update(unsigned int maxUploads = 0)
+    {
+        std::vector<std::shared_ptr<Job> > ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            unsigned int count = maxUploads == 0 || maxUploads > decoded.size() ? (unsigned int)decoded.size() : maxUploads;
+            ready.assign(decoded.begin(), decoded.begin() + count);
+            decoded.erase(decoded.begin(), decoded.begin() + count);
+        }
+        for (unsigned int i = 0; i < ready.size(); i++)
+        {
+            Job &job = *ready[i];
+            bool success = job.data != NULL;
+            if (success)
+                upload(job);
+            else
+                std::cout << "Texture failed to load at path: " << job.path << std::endl;
+            stbi_image_free(job.data);
+            job.data = NULL;
+            if (job.callback)
+                job.callback(job.id, success);
+            job.promise.set_value(success);
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+        }
+        return (unsigned int)ready.size();
+    }
+
+    // blocks until every queued texture is uploaded; must be called on the GL thread
+    void finish()
+    {
+        for (;;)
+        {
+            update();
+            std::unique_lock<std::mutex> lock(mutex);
+            if (pending == 0)
+                return;
+            while (decoded.empty())
+                wakeMain.wait(lock);
+        }
+    }
+
+    // number of textures that are queued, decoding or waiting for upload
+    unsigned int pendingCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending;
+    }
+
+    // stage uploads through a pixel unpack buffer so the driver can copy them asynchronously
+    bool usePixelBuffers;
+
+private:
+    struct Job
+    {
+        std::string path;
+        TextureOptions options;
+        Callback callback;
+        std::promise<bool> promise;
+        unsigned int id;
+        unsigned char *data;
+        int width, height, nrComponents;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeWorkers; // a job was queued or the loader is shutting down
+    std::condition_variable wakeMain;    // a job was decoded
+    std::deque<std::shared_ptr<Job> > queued;
+    std::vector<std::shared_ptr<Job> > decoded;
+    bool stopping;
+    unsigned int pending;
+
+    // worker thread: decode queued images until the loader is destroyed
+    void work()
+    {
+        for (;;)
+        {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (!stopping && queued.empty())
+                    wakeWorkers.wait(lock);
+                if (stopping)
+                    return;
+                job = queued.front();
+                queued.pop_front();
+            }
+            job->data = stbi_load(job->path.c_str(), &job->width, &job->height, &job->nrComponents, 0);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                decoded.push_back(job);
+            }
+            wakeMain.notify_one();
+        }
+    }
+
+    void uploadPlaceholder(unsigned int textureID)
+    {
+        const unsigned char texel[4] = { 128, 128, 128, 255 };
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    void upload(const Job &job)
+    {
+        GLenum internalFormat = GL_RGB;
+        GLenum dataFormat = GL_RGB;
+        if (job.nrComponents == 1)
+            internalFormat = dataFormat = GL_RED;
+        else if (job.nrComponents == 3)
+        {
+            internalFormat = job.options.gammaCorrection ? GL_SRGB : GL_RGB;
+            dataFormat = GL_RGB;
+        }
+        else if (job.nrComponents == 4)
+        {
+            internalFormat = job.options.gammaCorrection ? GL_SRGB_ALPHA : GL_RGBA;
+            dataFormat = GL_RGBA;
+        }
+        size_t size = (size_t)job.width * job.height * job.nrComponents;
+
+        glBindTexture(GL_TEXTURE_2D, job.id);
+        unsigned int pbo = 0;
+        const void *pixels = job.data;
+        if (usePixelBuffers)
+        {
+            // orphan a fresh buffer per upload so we never wait on a previous transfer
+            glGenBuffers(1, &pbo);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+            void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (mapped)
+            {
+                std::memcpy(mapped, job.data, size);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                pixels = 0; // offset into the bound unpack buffer
+            }
+            else
+            {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                glDeleteBuffers(1, &pbo);
+                pbo = 0;
+            }
+        }
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, job.width, job.height, 0, dataFormat, GL_UNSIGNED_BYTE, pixels);
+        if (pbo != 0)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &pbo); // the driver keeps the storage alive until the copy is done
+        }
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        GLint wrap = job.options.clampAlpha && dataFormat == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    TextureLoader(const TextureLoader&);
+    TextureLoader &operator=(const TextureLoader&);
+};
+#endif
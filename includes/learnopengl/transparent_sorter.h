@@ -0,0 +1,123 @@
+#ifndef TRANSPARENT_SORTER_H
+#define TRANSPARENT_SORTER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+// Back to front order of transparent objects that is kept from one frame to the next. The key of an object is its
+// squared distance to the camera; from frame to frame the camera barely moves, the previous order is nearly sorted
+// already and an insertion sort fixes it in close to linear time. When the insertion sort has to move too many objects
+// (the camera jumped, or it is the first frame) it gives up and a radix sort orders everything from scratch; counts
+// below radixThreshold always take the insertion sort. Objects at equal distances are all kept. Nothing is allocated
+// while sorting, only when the number of objects changes.
+// ------------------------------------------------------------------------------------------------------
+class TransparentSorter
+{
+public:
+    // counts below this are always insertion sorted
+    unsigned int radixThreshold;
+    // what the last sort() did
+    bool lastSortWasRadix;
+    unsigned long long lastSortMoves;
+
+    TransparentSorter() : radixThreshold(256), lastSortWasRadix(false), lastSortMoves(0) {}
+
+    // orders the count objects at positions from the furthest from cameraPosition to the nearest
+    void sort(const glm::vec3 *positions, unsigned int count, const glm::vec3 &cameraPosition)
+    {
+        if (count != entries.size())
+            reset(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            glm::vec3 offset = positions[entries[i].index] - cameraPosition;
+            entries[i].key = sortKey(glm::dot(offset, offset));
+        }
+        lastSortMoves = 0;
+        lastSortWasRadix = false;
+        // an insertion sort doing more than a few moves per object is on its way to quadratic
+        unsigned long long budget = count < radixThreshold ? ~0ull : 4ull * count;
+        if (!insertionSort(budget))
+        {
+            radixSort();
+            lastSortWasRadix = true;
+        }
+    }
+
+    unsigned int size() const { return (unsigned int)entries.size(); }
+    // index of the i-th object to draw, the furthest one first
+    unsigned int at(unsigned int i) const { return entries[i].index; }
+
+private:
+    struct Entry
+    {
+        uint32_t key;
+        unsigned int index;
+    };
+    std::vector<Entry> entries, scratch;
+
+    void reset(unsigned int count)
+    {
+        entries.resize(count);
+        scratch.resize(count);
+        for (unsigned int i = 0; i < count; i++)
+            entries[i].index = i;
+    }
+
+    // squared distances are never negative, so their bit patterns compare like the floats do; inverted to sort
+    // furthest first in ascending key order
+    static uint32_t sortKey(float squaredDistance)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &squaredDistance, sizeof(bits));
+        return ~bits;
+    }
+
+    // ascending by key; returns false, leaving the entries partly sorted, once more than budget moves were needed
+    bool insertionSort(unsigned long long budget)
+    {
+        for (unsigned int i = 1; i < entries.size(); i++)
+        {
+            Entry entry = entries[i];
+            unsigned int j = i;
+            while (j > 0 && entries[j - 1].key > entry.key)
+            {
+                entries[j] = entries[j - 1];
+                j--;
+            }
+            entries[j] = entry;
+            lastSortMoves += i - j;
+            if (lastSortMoves > budget)
+                return false;
+        }
+        return true;
+    }
+
+    // least significant digit radix sort over 11 bit digits; digits every key shares are skipped
+    void radixSort()
+    {
+        const unsigned int bits = 11, buckets = 1 << bits;
+        unsigned int counts[buckets];
+        for (unsigned int shift = 0; shift < 32; shift += bits)
+        {
+            std::memset(counts, 0, sizeof(counts));
+            for (unsigned int i = 0; i < entries.size(); i++)
+                counts[entries[i].key >> shift & (buckets - 1)]++;
+            if (entries.empty() || counts[entries[0].key >> shift & (buckets - 1)] == entries.size())
+                continue;
+            unsigned int offset = 0;
+            for (unsigned int digit = 0; digit < buckets; digit++)
+            {
+                unsigned int digitCount = counts[digit];
+                counts[digit] = offset;
+                offset += digitCount;
+            }
+            for (unsigned int i = 0; i < entries.size(); i++)
+                scratch[counts[entries[i].key >> shift & (buckets - 1)]++] = entries[i];
+            entries.swap(scratch);
+        }
+    }
+};
+#endif
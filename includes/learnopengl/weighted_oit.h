@@ -0,0 +1,155 @@
+#ifndef WEIGHTED_OIT_H
+#define WEIGHTED_OIT_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+
+#include <iostream>
+
+// Weighted blended order independent transparency (McGuire and Bavoil, 2013): transparent surfaces are drawn in any
+// order into two render targets that only add up and multiply, and a composite pass resolves them over the opaque
+// scene, so nothing has to be sorted. A frame goes
+//     oit.beginOpaque();       clear and draw the opaque geometry as usual
+//     oit.beginTransparent();  draw the transparent geometry (models, instances, ...) with a shader writing
+//                                  layout (location = 0) out vec4 accumulation; // vec4(color.rgb * color.a, color.a) * weight
+//                                  layout (location = 1) out vec4 revealage;    // vec4(color.a * weight, 0.0, 0.0, color.a)
+//     oit.composite();         resolve the result into the default framebuffer
+// Both targets are blended with one glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA), so this
+// needs no per attachment blend state and works on OpenGL 3.3: the color channels sum the weighted colors and weights,
+// the alpha of the second target multiplies up how much of the background is still visible. The composite shader
+// reads the three textures (units 0: opaque, 1: accumulation, 2: revealage) with texelFetch.
+// The targets have to match the framebuffer composited into, call resize() when the window's framebuffer changes.
+// beginOpaque() sets the viewport to the targets, composite() restores the one it replaced and leaves blending
+// disabled and depth testing and writes enabled.
+// ------------------------------------------------------------------------------------------------------
+class WeightedBlendedOIT
+{
+public:
+    WeightedBlendedOIT(const Shader &compositeShader, unsigned int width, unsigned int height)
+        : compositeShader(compositeShader), width(0), height(0), opaqueFBO(0), transparentFBO(0), opaqueColor(0), accumulation(0),
+          revealage(0), depthBuffer(0), quadVAO(0)
+    {
+        glGenFramebuffers(1, &opaqueFBO);
+        glGenFramebuffers(1, &transparentFBO);
+        glGenTextures(1, &opaqueColor);
+        glGenTextures(1, &accumulation);
+        glGenTextures(1, &revealage);
+        glGenRenderbuffers(1, &depthBuffer);
+        // the composite pass draws a single triangle covering the screen, generated from gl_VertexID
+        glGenVertexArrays(1, &quadVAO);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        resize(width, height);
+
+        compositeShader.use();
+        compositeShader.setInt("opaque", 0);
+        compositeShader.setInt("accumulation", 1);
+        compositeShader.setInt("revealage", 2);
+    }
+    ~WeightedBlendedOIT()
+    {
+        glDeleteFramebuffers(1, &opaqueFBO);
+        glDeleteFramebuffers(1, &transparentFBO);
+        unsigned int textures[3] = { opaqueColor, accumulation, revealage };
+        glDeleteTextures(3, textures);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        glDeleteVertexArrays(1, &quadVAO);
+    }
+
+    // reallocates the render targets, e.g. from the framebuffer size callback
+    void resize(unsigned int width, unsigned int height)
+    {
+        if (width == this->width && height == this->height)
+            return;
+        this->width = width;
+        this->height = height;
+        allocate(opaqueColor, GL_RGBA8, GL_UNSIGNED_BYTE);
+        // the weighted sums need the range of floats, 16 bits are plenty
+        allocate(accumulation, GL_RGBA16F, GL_HALF_FLOAT);
+        allocate(revealage, GL_RGBA16F, GL_HALF_FLOAT);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        // the transparent pass tests against the opaque pass's depth, so both framebuffers share the depth buffer
+        glBindFramebuffer(GL_FRAMEBUFFER, opaqueFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, opaqueColor, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::OIT::Opaque framebuffer is not complete" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, transparentFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulation, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, revealage, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::OIT::Transparent framebuffer is not complete" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void beginOpaque()
+    {
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, opaqueFBO);
+        glViewport(0, 0, width, height);
+    }
+
+    void beginTransparent()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, transparentFBO);
+        // nothing accumulated yet, the background is fully visible
+        const float clearAccumulation[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const float clearRevealage[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+        glClearBufferfv(GL_COLOR, 1, clearRevealage);
+        // test against the opaque depth but keep every transparent layer
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // resolves the transparent layers over the opaque scene into framebuffer
+    void composite(unsigned int framebuffer = 0)
+    {
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glDisable(GL_DEPTH_TEST);
+        compositeShader.use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, opaqueColor);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, accumulation);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, revealage);
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glActiveTexture(GL_TEXTURE0);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+private:
+    const Shader &compositeShader;
+    unsigned int width, height;
+    unsigned int opaqueFBO, transparentFBO;
+    unsigned int opaqueColor, accumulation, revealage;
+    unsigned int depthBuffer;
+    unsigned int quadVAO;
+    GLint viewport[4]; // the caller's, saved by beginOpaque()
+
+    void allocate(unsigned int texture, GLenum internalFormat, GLenum type)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    WeightedBlendedOIT(const WeightedBlendedOIT&);
+    WeightedBlendedOIT &operator=(const WeightedBlendedOIT&);
+};
+#endif
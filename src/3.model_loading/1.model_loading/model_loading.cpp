@@ -79,9 +79,16 @@ int main()
 
     // load models
     // -----------
-    Model ourModel(FileSystem::getPath("resources/objects/nanosuit/nanosuit.obj"));
+    // the meshes are reordered for the vertex cache on import, the optimized result is stored in the model's binary cache
+    Model ourModel(FileSystem::getPath("resources/objects/nanosuit/nanosuit.obj"), false, true, FULL_VERTEX, true);
+    if(ourModel.cacheStatsBefore.triangles > 0)
+        std::cout << "vertex cache ACMR " << ourModel.cacheStatsBefore.acmr() << " -> " << ourModel.cacheStatsAfter.acmr()
+                  << ", ATVR " << ourModel.cacheStatsBefore.atvr() << " -> " << ourModel.cacheStatsAfter.atvr() << std::endl;
+
+    // draws are queued and submitted sorted by state and depth
+    // -------------------------------------------------------
+    RenderQueue renderQueue;
 
-    
     // draw in wireframe
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -113,12 +120,13 @@ int main()
         ourShader.setMat4("projection", projection);
         ourShader.setMat4("view", view);
 
-        // render the loaded model
+        // render the loaded model; the queue orders its meshes by texture set and front to back and sets the model uniform
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, -1.75f, 0.0f)); // translate it down so it's at the center of the scene
         model = glm::scale(model, glm::vec3(0.2f, 0.2f, 0.2f));	// it's a bit too big for our scene, so scale it down
-        ourShader.setMat4("model", model);
-        ourModel.Draw(ourShader);
+        renderQueue.setView(camera.Position, camera.Front, 0.1f, 100.0f);
+        ourModel.Submit(renderQueue, ourShader, model);
+        renderQueue.flush();
 
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
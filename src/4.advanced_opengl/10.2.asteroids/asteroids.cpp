@@ -80,8 +80,10 @@ int main()
 
     // load models
     // -----------
-    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"));
-    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"));
+    // the rock only needs positions and texture coordinates, upload it in the compact vertex format
+    // both models are reordered for the vertex cache since they're drawn so often
+    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"), false, true, PACKED_VERTEX, true);
+    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"), false, true, FULL_VERTEX, true);
 
     // generate a large list of semi-random model transformation matrices
     // ------------------------------------------------------------------
@@ -116,6 +118,10 @@ int main()
         modelMatrices[i] = model;
     }
 
+    // culling statistics, summed over the frames since they were last printed (once per second)
+    unsigned int meshesTested = 0, meshesCulled = 0, statFrames = 0;
+    float lastStats = glfwGetTime();
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -141,21 +147,40 @@ int main()
         shader.use();
         shader.setMat4("projection", projection);
         shader.setMat4("view", view);
+        // most of the asteroid field is behind or beside the camera, only draw what's inside its view
+        Frustum frustum(projection * view);
 
         // draw planet
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
         model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
         shader.setMat4("model", model);
-        planet.Draw(shader);
+        planet.Draw(shader, frustum, model);
 
         // draw meteorites
         for (unsigned int i = 0; i < amount; i++)
         {
+            // test before setting the uniform, so culled rocks cost nothing but the test
+            frustum.meshesTested += (unsigned int)rock.meshes.size();
+            if (!rock.IsVisible(frustum, modelMatrices[i]))
+            {
+                frustum.meshesCulled += (unsigned int)rock.meshes.size();
+                continue;
+            }
             shader.setMat4("model", modelMatrices[i]);
             rock.Draw(shader);
         }     
 
+        meshesTested += frustum.meshesTested;
+        meshesCulled += frustum.meshesCulled;
+        statFrames++;
+        if (currentFrame - lastStats >= 1.0f)
+        {
+            std::cout << "frustum culling: " << meshesCulled / statFrames << " of " << meshesTested / statFrames << " meshes culled per frame" << std::endl;
+            meshesTested = meshesCulled = statFrames = 0;
+            lastStats = currentFrame;
+        }
+
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
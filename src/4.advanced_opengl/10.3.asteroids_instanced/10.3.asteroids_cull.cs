@@ -0,0 +1,51 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Instances { mat4 instances[]; };
+layout (std430, binding = 1) writeonly buffer VisibleInstances { mat4 visibleInstances[]; };
+layout (std430, binding = 2) buffer DrawCommands { DrawCommand commands[]; };
+
+const int MAX_LODS = 8;
+
+uniform vec4 frustumPlanes[6];
+uniform vec4 boundingSphere; // model space center and radius
+uniform vec3 cameraPosition;
+uniform float lodErrors[MAX_LODS]; // model space error of each LOD, ascending
+uniform float errorScale; // screen space error per unit of error at distance 1, in units of the pixel threshold
+uniform int lodCount;
+uniform int instanceCount;
+
+void main()
+{
+    int index = int(gl_GlobalInvocationID.x);
+    if (index >= instanceCount)
+        return;
+
+    // bounding sphere in world space
+    mat4 model = instances[index];
+    vec3 center = vec3(model * vec4(boundingSphere.xyz, 1.0));
+    float scale = sqrt(max(dot(model[0].xyz, model[0].xyz), max(dot(model[1].xyz, model[1].xyz), dot(model[2].xyz, model[2].xyz))));
+    float radius = boundingSphere.w * scale;
+    for (int i = 0; i < 6; i++)
+        if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius)
+            return;
+
+    // least detailed LOD whose error, projected to the screen, stays below the pixel threshold
+    float distance = length(center - cameraPosition);
+    int lod = 0;
+    while (lod < lodCount - 1 && lodErrors[lod + 1] * scale * errorScale <= distance)
+        lod++;
+
+    // append to the LOD's range of the visible instances
+    uint slot = atomicAdd(commands[lod].instanceCount, 1u);
+    visibleInstances[commands[lod].baseInstance + slot] = model;
+}
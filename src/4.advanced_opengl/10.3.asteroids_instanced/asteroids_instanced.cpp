@@ -10,13 +10,23 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/frustum.h>
+#include <learnopengl/gpu_culling.h>
+#include <learnopengl/instance_culling.h>
+#include <learnopengl/stream_buffer.h>
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
+void generateAsteroidField(glm::mat4 *modelMatrices, unsigned int amount);
+void setInstanceMatrixAttributes(unsigned int VAO, GLintptr offset);
+void benchmarkCulling();
 
 // settings
 const unsigned int SCR_WIDTH = 1280;
@@ -32,8 +42,19 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+// culling: press G to switch between culling on the CPU and on the GPU (needs OpenGL 4.3)
+bool gpuCulling = false;
+bool gpuCullingKeyPressed = false;
+
+int main(int argc, char *argv[])
 {
+    // '--benchmark' compares the culling kernels on the CPU and exits without opening a window
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        benchmarkCulling();
+        return 0;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -81,8 +102,11 @@ int main()
 
     // load models
     // -----------
-    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"));
-    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"));
+    // the rock only needs positions and texture coordinates, upload it in the compact vertex format
+    // both models are reordered for the vertex cache since they're drawn so often, and the rock gets a chain of
+    // simplified LODs for the many asteroids that only cover a few pixels
+    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"), false, true, PACKED_VERTEX, true, 4);
+    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"), false, true, FULL_VERTEX, true);
 
     // generate a large list of semi-random model transformation matrices
     // ------------------------------------------------------------------
@@ -90,65 +114,33 @@ int main()
     glm::mat4* modelMatrices;
     modelMatrices = new glm::mat4[amount];
     srand(glfwGetTime()); // initialize random seed	
-    float radius = 150.0;
-    float offset = 25.0f;
-    for (unsigned int i = 0; i < amount; i++)
+    generateAsteroidField(modelMatrices, amount);
+
+    // the rock is a single mesh; an asteroid uses the least detailed LOD whose error stays below a pixel on screen
+    const Mesh &rockMesh = rock.meshes[0];
+    const float lodPixelThreshold = 1.0f;
+    for (unsigned int i = 0; i < rockMesh.lods.size(); i++)
+        std::cout << "rock LOD " << i << ": " << rockMesh.lods[i].indexCount / 3 << " triangles, error " << rockMesh.lods[i].error << std::endl;
+    std::vector<unsigned int> lodCounts(rockMesh.lods.size()), lodOffsets(rockMesh.lods.size());
+
+    // every frame only the matrices of the asteroids inside the camera's view are written to the instance buffer,
+    // grouped by LOD
+    // ----------------------------------------------------------------------------------------------------------
+    InstanceCuller culler;
+    culler.setInstances(modelMatrices, amount, rock.boundsCenter, rock.boundsRadius);
+    StreamBuffer instanceBuffer(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4));
+
+    // alternatively culling runs in a compute shader that fills the draw commands of a single multi draw indirect call
+    Shader *cullShader = NULL;
+    GPUCuller *gpuCuller = NULL;
+    if (GLAD_GL_VERSION_4_3)
     {
-        glm::mat4 model = glm::mat4(1.0f);
-        // 1. translation: displace along circle with 'radius' in range [-offset, offset]
-        float angle = (float)i / (float)amount * 360.0f;
-        float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float x = sin(angle) * radius + displacement;
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float y = displacement * 0.4f; // keep height of asteroid field smaller compared to width of x and z
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float z = cos(angle) * radius + displacement;
-        model = glm::translate(model, glm::vec3(x, y, z));
-
-        // 2. scale: Scale between 0.05 and 0.25f
-        float scale = (rand() % 20) / 100.0f + 0.05;
-        model = glm::scale(model, glm::vec3(scale));
-
-        // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
-        float rotAngle = (rand() % 360);
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-        // 4. now add to list of matrices
-        modelMatrices[i] = model;
-    }
-
-    // configure instanced array
-    // -------------------------
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
-
-    // set transformation matrices as an instance vertex attribute (with divisor 1)
-    // note: we're cheating a little by taking the, now publicly declared, VAO of the model's mesh(es) and adding new vertexAttribPointers
-    // normally you'd want to do this in a more organized fashion, but for learning purposes this will do.
-    // -----------------------------------------------------------------------------------------------------------------------------------
-    for (unsigned int i = 0; i < rock.meshes.size(); i++)
-    {
-        unsigned int VAO = rock.meshes[i].VAO;
-        glBindVertexArray(VAO);
-        // set attribute pointers for matrix (4 times vec4)
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-
-        glBindVertexArray(0);
+        cullShader = new Shader("10.3.asteroids_cull.cs");
+        gpuCuller = new GPUCuller(*cullShader, rockMesh);
+        gpuCuller->setInstances(modelMatrices, amount, rock.boundsCenter, rock.boundsRadius);
     }
+    else
+        std::cout << "GPU culling requires OpenGL 4.3, culling on the CPU only" << std::endl;
 
     // render loop
     // -----------
@@ -191,11 +183,31 @@ int main()
         asteroidShader.setInt("texture_diffuse1", 0);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, rock.textures_loaded[0].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
-        for (unsigned int i = 0; i < rock.meshes.size(); i++)
+        Frustum frustum(projection * view);
+        float errorScale = lodErrorScale(glm::radians(45.0f), (float)SCR_HEIGHT, lodPixelThreshold);
+        if (gpuCulling && gpuCuller)
         {
-            glBindVertexArray(rock.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, rock.meshes[i].indices.size(), GL_UNSIGNED_INT, 0, amount);
+            // cull and pick the LODs on the GPU, then draw whatever survived without reading anything back
+            gpuCuller->cull(frustum, camera.Position, errorScale);
+            asteroidShader.use();
+            gpuCuller->Draw();
+        }
+        else
+        {
+            // cull the asteroids straight into this frame's region of the instance buffer, sorted into one range per LOD
+            culler.cullLods(frustum, rockMesh, camera.Position, errorScale, (glm::mat4*)instanceBuffer.map(), &lodCounts[0], &lodOffsets[0]);
+            instanceBuffer.unmap();
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.ID);
+            for (unsigned int lod = 0; lod < rockMesh.lods.size(); lod++)
+            {
+                if (lodCounts[lod] == 0)
+                    continue;
+                // the region changes every frame, so point the instance attributes at this LOD's range of it (this also binds the VAO)
+                setInstanceMatrixAttributes(rockMesh.VAO, instanceBuffer.offset() + lodOffsets[lod] * sizeof(glm::mat4));
+                glDrawElementsInstanced(GL_TRIANGLES, rockMesh.lods[lod].indexCount, rockMesh.indexType, rockMesh.IndexOffset(lod), lodCounts[lod]);
+            }
             glBindVertexArray(0);
+            instanceBuffer.fence();
         }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -204,10 +216,93 @@ int main()
         glfwPollEvents();
     }
 
+    delete gpuCuller;
+    delete cullShader;
+    delete[] modelMatrices;
     glfwTerminate();
     return 0;
 }
 
+// places the asteroids in a ring around the planet with random scale and rotation
+// -------------------------------------------------------------------------------
+void generateAsteroidField(glm::mat4 *modelMatrices, unsigned int amount)
+{
+    float radius = 150.0;
+    float offset = 25.0f;
+    for (unsigned int i = 0; i < amount; i++)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        // 1. translation: displace along circle with 'radius' in range [-offset, offset]
+        float angle = (float)i / (float)amount * 360.0f;
+        float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+        float x = sin(angle) * radius + displacement;
+        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+        float y = displacement * 0.4f; // keep height of asteroid field smaller compared to width of x and z
+        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+        float z = cos(angle) * radius + displacement;
+        model = glm::translate(model, glm::vec3(x, y, z));
+
+        // 2. scale: Scale between 0.05 and 0.25f
+        float scale = (rand() % 20) / 100.0f + 0.05;
+        model = glm::scale(model, glm::vec3(scale));
+
+        // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
+        float rotAngle = (rand() % 360);
+        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
+
+        // 4. now add to list of matrices
+        modelMatrices[i] = model;
+    }
+}
+
+// set transformation matrices as an instance vertex attribute (with divisor 1), read from the buffer bound to GL_ARRAY_BUFFER at offset
+// note: we're cheating a little by taking the, now publicly declared, VAO of the model's mesh(es) and adding new vertexAttribPointers
+// normally you'd want to do this in a more organized fashion, but for learning purposes this will do.
+// -----------------------------------------------------------------------------------------------------------------------------------
+void setInstanceMatrixAttributes(unsigned int VAO, GLintptr offset)
+{
+    glBindVertexArray(VAO);
+    // set attribute pointers for matrix (4 times vec4)
+    for (unsigned int column = 0; column < 4; column++)
+    {
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(3 + column, 1);
+    }
+}
+
+// times every culling kernel the CPU supports on 100k and 1M asteroids seen from the demo's starting position
+// ------------------------------------------------------------------------------------------------------------
+void benchmarkCulling()
+{
+    const char *pathNames[] = { "scalar", "SSE", "AVX2" };
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+    Frustum frustum(projection * camera.GetViewMatrix());
+    unsigned int amounts[] = { 100000, 1000000 };
+    for (unsigned int a = 0; a < 2; a++)
+    {
+        std::vector<glm::mat4> modelMatrices(amounts[a]);
+        std::vector<glm::mat4> visibleMatrices(amounts[a]);
+        srand(1);
+        generateAsteroidField(&modelMatrices[0], amounts[a]);
+        InstanceCuller culler;
+        culler.setInstances(&modelMatrices[0], amounts[a], glm::vec3(0.0f), 1.0f);
+        for (int path = CULL_SCALAR; path <= CULL_AVX2; path++)
+        {
+            if (!InstanceCuller::supported((Culling_Path)path))
+                continue;
+            culler.path = (Culling_Path)path;
+            const unsigned int runs = 20;
+            unsigned int visible = culler.cull(frustum, &visibleMatrices[0]); // warm up
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (unsigned int run = 0; run < runs; run++)
+                visible = culler.cull(frustum, &visibleMatrices[0]);
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+            std::cout << amounts[a] << " instances, " << pathNames[path] << ": " << milliseconds << " ms, " << visible << " visible" << std::endl;
+        }
+    }
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window)
@@ -223,6 +318,15 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !gpuCullingKeyPressed)
+    {
+        gpuCulling = !gpuCulling;
+        gpuCullingKeyPressed = true;
+        std::cout << (gpuCulling ? "culling on the GPU" : "culling on the CPU") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE)
+        gpuCullingKeyPressed = false;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) out vec4 accumulation;
+layout (location = 1) out vec4 revealage;
+
+in vec2 TexCoords;
+
+uniform sampler2D texture1;
+
+void main()
+{             
+    vec4 color = texture(texture1, TexCoords);
+    // nearer and more opaque surfaces weigh more (McGuire and Bavoil, equation 10 with gl_FragCoord.z as depth)
+    float weight = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    accumulation = vec4(color.rgb * color.a, color.a) * weight;
+    revealage = vec4(color.a * weight, 0.0, 0.0, color.a);
+}
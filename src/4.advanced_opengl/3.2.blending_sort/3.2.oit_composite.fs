@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D opaque;
+uniform sampler2D accumulation;
+uniform sampler2D revealage;
+
+void main()
+{             
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 background = texelFetch(opaque, texel, 0).rgb;
+    vec3 weightedColor = texelFetch(accumulation, texel, 0).rgb;
+    vec4 weightsAndRevealage = texelFetch(revealage, texel, 0);
+    // weighted average of the transparent layers, laid over the part of the background they hide
+    vec3 average = weightedColor / max(weightsAndRevealage.r, 1e-5);
+    FragColor = vec4(mix(average, background, weightsAndRevealage.a), 1.0);
+}
@@ -10,14 +10,23 @@
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/transparent_sorter.h>
+#include <learnopengl/weighted_oit.h>
 
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdlib>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path);
+void benchmarkSorting();
 
 // settings
 const unsigned int SCR_WIDTH = 1280;
@@ -33,8 +42,21 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+// press O to switch between sorting the windows and order independent transparency
+bool orderIndependent = false;
+bool orderIndependentKeyPressed = false;
+// its render targets, resized along with the window's framebuffer
+WeightedBlendedOIT *oitTargets = NULL;
+
+int main(int argc, char *argv[])
 {
+    // '--benchmark' times sorting 10k to 1M transparent quads for a moving camera and exits without opening a window
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        benchmarkSorting();
+        return 0;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -80,6 +102,8 @@ int main()
     // build and compile shaders
     // -------------------------
     Shader shader("3.2.blending.vs", "3.2.blending.fs");
+    Shader oitShader("3.2.blending.vs", "3.2.blending_oit.fs");
+    Shader oitCompositeShader("3.2.oit_composite.vs", "3.2.oit_composite.fs");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -199,10 +223,21 @@ int main()
         glm::vec3( 0.5f, 0.0f, -0.6f)
     };
 
+    // the windows' back to front order, kept and updated from frame to frame
+    TransparentSorter sorter;
+    // render targets of the order independent mode
+    // (the framebuffer can be larger than the window, e.g. on retina displays)
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    WeightedBlendedOIT oit(oitCompositeShader, framebufferWidth, framebufferHeight);
+    oitTargets = &oit;
+
     // shader configuration
     // --------------------
     shader.use();
     shader.setInt("texture1", 0);
+    oitShader.use();
+    oitShader.setInt("texture1", 0);
 
     // render loop
     // -----------
@@ -218,17 +253,15 @@ int main()
         // -----
         processInput(window);
 
-        // sort the transparent windows before rendering
-        // ---------------------------------------------
-        std::map<float, glm::vec3> sorted;
-        for (unsigned int i = 0; i < windows.size(); i++)
-        {
-            float distance = glm::length(camera.Position - windows[i]);
-            sorted[distance] = windows[i];
-        }
+        // sort the transparent windows before rendering, unless their order doesn't matter
+        // ---------------------------------------------------------------------------------
+        if (!orderIndependent)
+            sorter.sort(&windows[0], (unsigned int)windows.size(), camera.Position);
 
         // render
         // ------
+        if (orderIndependent)
+            oit.beginOpaque();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -256,15 +289,36 @@ int main()
         model = glm::mat4(1.0f);
         shader.setMat4("model", model);
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        // windows (from furthest to nearest)
         glBindVertexArray(transparentVAO);
         glBindTexture(GL_TEXTURE_2D, transparentTexture);
-        for (std::map<float, glm::vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+        if (orderIndependent)
         {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, it->second);
-            shader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            // windows (in any order, the composite pass weighs them by depth and opacity)
+            oit.beginTransparent();
+            oitShader.use();
+            oitShader.setMat4("projection", projection);
+            oitShader.setMat4("view", view);
+            for (unsigned int i = 0; i < windows.size(); i++)
+            {
+                model = glm::mat4(1.0f);
+                model = glm::translate(model, windows[i]);
+                oitShader.setMat4("model", model);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+            oit.composite();
+        }
+        else
+        {
+            // windows (from furthest to nearest)
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            for (unsigned int i = 0; i < sorter.size(); i++)
+            {
+                model = glm::mat4(1.0f);
+                model = glm::translate(model, windows[sorter.at(i)]);
+                shader.setMat4("model", model);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
         }
 
 
@@ -285,6 +339,69 @@ int main()
     return 0;
 }
 
+// times sorting 10k, 100k and 1M quads back to front over frames of a slowly moving camera, rebuilding a std::map
+// every frame (the way this demo used to), std::sort'ing every frame and with the incremental TransparentSorter
+// ------------------------------------------------------------------------------------------------------------
+void benchmarkSorting()
+{
+    unsigned int amounts[] = { 10000, 100000, 1000000 };
+    for (unsigned int a = 0; a < 3; a++)
+    {
+        unsigned int amount = amounts[a];
+        // quads scattered through a box of 100 units, the camera walks through it
+        std::vector<glm::vec3> positions(amount);
+        srand(1);
+        for (unsigned int i = 0; i < amount; i++)
+            positions[i] = glm::vec3(rand() % 10000, rand() % 10000, rand() % 10000) / 100.0f - 50.0f;
+        const unsigned int frames = amount > 100000 ? 10 : 60;
+        std::vector<glm::vec3> cameraPath(frames);
+        for (unsigned int frame = 0; frame < frames; frame++)
+            cameraPath[frame] = glm::vec3(frame * 0.05f, 1.0f, 3.0f - frame * 0.02f);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t drawn = 0;
+        for (unsigned int frame = 0; frame < frames; frame++)
+        {
+            std::map<float, glm::vec3> sorted;
+            for (unsigned int i = 0; i < amount; i++)
+                sorted[glm::length(cameraPath[frame] - positions[i])] = positions[i];
+            drawn = sorted.size();
+        }
+        double mapMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        std::vector<std::pair<float, unsigned int> > keys(amount);
+        start = std::chrono::steady_clock::now();
+        for (unsigned int frame = 0; frame < frames; frame++)
+        {
+            for (unsigned int i = 0; i < amount; i++)
+            {
+                glm::vec3 offset = positions[i] - cameraPath[frame];
+                keys[i] = std::make_pair(-glm::dot(offset, offset), i);
+            }
+            std::sort(keys.begin(), keys.end());
+        }
+        double sortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        // the first sort is a radix sort from scratch, the ones after it are incremental
+        TransparentSorter sorter;
+        start = std::chrono::steady_clock::now();
+        sorter.sort(&positions[0], amount, cameraPath[0]);
+        double firstMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        unsigned int radixSorts = 0;
+        start = std::chrono::steady_clock::now();
+        for (unsigned int frame = 1; frame < frames; frame++)
+        {
+            sorter.sort(&positions[0], amount, cameraPath[frame]);
+            radixSorts += sorter.lastSortWasRadix ? 1 : 0;
+        }
+        double sorterMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / (frames - 1);
+
+        std::cout << amount << " quads: std::map " << mapMilliseconds << " ms (" << amount - drawn << " dropped), std::sort "
+                  << sortMilliseconds << " ms, TransparentSorter " << firstMilliseconds << " ms first frame, " << sorterMilliseconds
+                  << " ms per frame after (" << radixSorts << " of " << frames - 1 << " radix sorted)" << std::endl;
+    }
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window)
@@ -300,6 +417,16 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS && !orderIndependentKeyPressed)
+    {
+        orderIndependent = !orderIndependent;
+        orderIndependentKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE)
+    {
+        orderIndependentKeyPressed = false;
+    }
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -309,6 +436,8 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    if (oitTargets != NULL)
+        oitTargets->resize(width, height);
 }
 
 // glfw: whenever the mouse moves, this callback is called
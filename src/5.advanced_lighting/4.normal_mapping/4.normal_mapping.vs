@@ -2,8 +2,13 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#ifdef PACKED_TANGENT
+// PackedVertex (see mesh.h): no bitangent, the tangent's w holds the handedness of the tangent frame
+layout (location = 3) in vec4 aTangent;
+#else
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
+#endif
 
 out VS_OUT {
     vec3 FragPos;
@@ -26,10 +31,14 @@ void main()
     vs_out.TexCoords = aTexCoords;
     
     mat3 normalMatrix = transpose(inverse(mat3(model)));
-    vec3 T = normalize(normalMatrix * aTangent);
+    vec3 T = normalize(normalMatrix * aTangent.xyz);
     vec3 N = normalize(normalMatrix * aNormal);
     T = normalize(T - dot(T, N) * N);
+#ifdef PACKED_TANGENT
+    vec3 B = cross(N, T) * aTangent.w;
+#else
     vec3 B = cross(N, T);
+#endif
     
     mat3 TBN = transpose(mat3(T, B, N));    
     vs_out.TangentLightPos = TBN * lightPos;
@@ -12,6 +12,7 @@
 #include <learnopengl/model.h>
 
 #include <iostream>
+#include <cstring>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -34,8 +35,17 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+// draw the quad from PackedVertex data instead of full float vertices
+bool packedQuad = false;
+
+int main(int argc, char *argv[])
 {
+    // --packed uploads the quad as PackedVertex (24 instead of 56 bytes a vertex), shaded by the variant of the
+    // vertex shader that rebuilds the bitangent from the normal and the tangent's handedness
+    for (int i = 1; i < argc; i++)
+        if (std::string(argv[i]) == "--packed")
+            packedQuad = true;
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -78,7 +88,10 @@ int main()
 
     // build and compile shaders
     // -------------------------
-    Shader shader("4.normal_mapping.vs", "4.normal_mapping.fs");
+    ShaderDefines defines;
+    if (packedQuad)
+        defines["PACKED_TANGENT"] = "";
+    Shader shader("4.normal_mapping.vs", "4.normal_mapping.fs", defines);
 
     // load textures
     // -------------
@@ -228,17 +241,33 @@ void renderQuad()
         glGenBuffers(1, &quadVBO);
         glBindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(6 * sizeof(float)));
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(8 * sizeof(float)));
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(11 * sizeof(float)));
+        if (packedQuad)
+        {
+            // each row above is laid out like a Vertex
+            PackedVertex packedVertices[6];
+            for (unsigned int i = 0; i < 6; i++)
+            {
+                Vertex vertex;
+                std::memcpy(&vertex, &quadVertices[i * 14], sizeof(Vertex));
+                packedVertices[i] = packVertex(vertex);
+            }
+            glBufferData(GL_ARRAY_BUFFER, sizeof(packedVertices), &packedVertices, GL_STATIC_DRAW);
+            Mesh::SetupVertexAttributes(PACKED_VERTEX);
+        }
+        else
+        {
+            glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(6 * sizeof(float)));
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(8 * sizeof(float)));
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(11 * sizeof(float)));
+        }
     }
     glBindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
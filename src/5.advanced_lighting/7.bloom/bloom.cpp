@@ -10,6 +10,7 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/profiler.h>
 
 #include <iostream>
 
@@ -171,6 +172,10 @@ int main()
     shaderBloomFinal.setInt("scene", 0);
     shaderBloomFinal.setInt("bloomBlur", 1);
 
+    // per pass CPU and GPU timings, reported when the demo exits
+    // ----------------------------------------------------------
+    Profiler profiler;
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -187,11 +192,13 @@ int main()
 
         // render
         // ------
+        profiler.beginFrame();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 1. render scene into floating point framebuffer
         // -----------------------------------------------
+        profiler.begin("scene");
         glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
@@ -270,9 +277,11 @@ int main()
             renderCube();
         }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
         // 2. blur bright fragments with two-pass Gaussian Blur 
         // --------------------------------------------------
+        profiler.begin("blur");
         bool horizontal = true, first_iteration = true;
         unsigned int amount = 10;
         shaderBlur.use();
@@ -287,9 +296,11 @@ int main()
                 first_iteration = false;
         }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
         // 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
         // --------------------------------------------------------------------------------------------------------------------------
+        profiler.begin("tonemap");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shaderBloomFinal.use();
         glActiveTexture(GL_TEXTURE0);
@@ -299,6 +310,8 @@ int main()
         shaderBloomFinal.setInt("bloom", bloom);
         shaderBloomFinal.setFloat("exposure", exposure);
         renderQuad();
+        profiler.end();
+        profiler.endFrame();
 
         std::cout << "bloom: " << (bloom ? "on" : "off") << "| exposure: " << exposure << std::endl;
 
@@ -308,6 +321,10 @@ int main()
         glfwPollEvents();
     }
 
+    profiler.report(std::cout);
+    profiler.writeCSV("7.bloom.profile.csv");
+    profiler.writeChromeTrace("7.bloom.trace.json");
+
     glfwTerminate();
     return 0;
 }
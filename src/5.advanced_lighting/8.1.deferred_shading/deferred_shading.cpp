@@ -9,6 +9,7 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/profiler.h>
 
 #include <iostream>
 
@@ -165,6 +166,10 @@ int main()
     shaderLightingPass.setInt("gNormal", 1);
     shaderLightingPass.setInt("gAlbedoSpec", 2);
 
+    // per pass CPU and GPU timings, reported when the demo exits
+    // ----------------------------------------------------------
+    Profiler profiler;
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -181,11 +186,13 @@ int main()
 
         // render
         // ------
+        profiler.beginFrame();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
+        profiler.begin("geometry");
         glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
@@ -194,18 +201,22 @@ int main()
             shaderGeometryPass.use();
             shaderGeometryPass.setMat4("projection", projection);
             shaderGeometryPass.setMat4("view", view);
+            // skip the meshes that are outside the camera's view
+            Frustum frustum(projection * view);
             for (unsigned int i = 0; i < objectPositions.size(); i++)
             {
                 model = glm::mat4(1.0f);
                 model = glm::translate(model, objectPositions[i]);
                 model = glm::scale(model, glm::vec3(0.25f));
                 shaderGeometryPass.setMat4("model", model);
-                nanosuit.Draw(shaderGeometryPass);
+                nanosuit.Draw(shaderGeometryPass, frustum, model);
             }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
         // 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content.
         // -----------------------------------------------------------------------------------------------------------------------
+        profiler.begin("lighting");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shaderLightingPass.use();
         glActiveTexture(GL_TEXTURE0);
@@ -229,9 +240,11 @@ int main()
         shaderLightingPass.setVec3("viewPos", camera.Position);
         // finally render quad
         renderQuad();
+        profiler.end();
 
         // 2.5. copy content of geometry's depth buffer to default framebuffer's depth buffer
         // ----------------------------------------------------------------------------------
+        profiler.begin("depth copy");
         glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
         // blit to default framebuffer. Note that this may or may not work as the internal formats of both the FBO and default framebuffer have to match.
@@ -239,9 +252,11 @@ int main()
         // depth buffer in another shader stage (or somehow see to match the default framebuffer's internal format with the FBO's internal format).
         glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
         // 3. render lights on top of scene
         // --------------------------------
+        profiler.begin("light boxes");
         shaderLightBox.use();
         shaderLightBox.setMat4("projection", projection);
         shaderLightBox.setMat4("view", view);
@@ -254,6 +269,9 @@ int main()
             shaderLightBox.setVec3("lightColor", lightColors[i]);
             renderCube();
         }
+        profiler.end();
+        profiler.endFrame();
+        RenderState::shared().endFrame();
 
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -262,6 +280,12 @@ int main()
         glfwPollEvents();
     }
 
+    profiler.report(std::cout);
+    // GL state changes of the last frame, issued to the driver or filtered as redundant
+    RenderState::shared().report(std::cout);
+    profiler.writeCSV("8.1.deferred_shading.profile.csv");
+    profiler.writeChromeTrace("8.1.deferred_shading.trace.json");
+
     glfwTerminate();
     return 0;
 }
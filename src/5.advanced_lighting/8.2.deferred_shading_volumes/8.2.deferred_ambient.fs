@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D gAlbedoSpec;
+
+void main()
+{             
+    // the light volumes add up on top of the ambient lighting of every pixel
+    vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
+    FragColor = vec4(Diffuse * 0.1, 1.0); // hard-coded ambient component
+}
@@ -15,9 +15,12 @@ struct Light {
     float Quadratic;
     float Radius;
 };
-const int NR_LIGHTS = 32;
+// defined by the demo to the number of lights it shades
+#ifndef NR_LIGHTS
+#define NR_LIGHTS 32
+#endif
 uniform Light lights[NR_LIGHTS];
-uniform vec3 viewPos;
+#include "frame_data.glsl"
 
 void main()
 {             
@@ -29,7 +32,7 @@ void main()
     
     // then calculate lighting as usual
     vec3 lighting  = Diffuse * 0.1; // hard-coded ambient component
-    vec3 viewDir  = normalize(viewPos - FragPos);
+    vec3 viewDir  = normalize(cameraPosition - FragPos);
     for(int i = 0; i < NR_LIGHTS; ++i)
     {
         // calculate distance between light source and current fragment
@@ -0,0 +1,64 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+
+// light culling results of LightClusters, see light_clusters.h
+uniform samplerBuffer lightData;      // per light: (position, radius), (color, linear), (quadratic, -, -, -)
+uniform usamplerBuffer clusterRanges; // per cluster: offset and count of its lights in lightIndices
+uniform usamplerBuffer lightIndices;
+uniform uvec3 clusterGrid;
+uniform vec2 clusterTileSize;
+uniform float clusterSliceScale;
+uniform float clusterSliceBias;
+uniform mat4 clusterView;
+
+#include "frame_data.glsl"
+
+void main()
+{             
+    // retrieve data from gbuffer
+    vec3 FragPos = texture(gPosition, TexCoords).rgb;
+    vec3 Normal = texture(gNormal, TexCoords).rgb;
+    vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
+    float Specular = texture(gAlbedoSpec, TexCoords).a;
+
+    // find the cluster of this fragment: its screen tile and the depth slice of its view space depth
+    float depth = max(-(clusterView * vec4(FragPos, 1.0)).z, 1e-4);
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize), clusterGrid.xy - 1u);
+    uint slice = uint(clamp(log(depth) * clusterSliceScale + clusterSliceBias, 0.0, float(clusterGrid.z - 1u)));
+    uvec2 range = texelFetch(clusterRanges, int(tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice))).rg;
+    
+    // then calculate lighting as usual, but only with the lights that reach this cluster
+    vec3 lighting  = Diffuse * 0.1; // hard-coded ambient component
+    vec3 viewDir  = normalize(cameraPosition - FragPos);
+    for(uint i = range.x; i < range.x + range.y; ++i)
+    {
+        int light = int(texelFetch(lightIndices, int(i)).r) * 3;
+        vec4 positionRadius = texelFetch(lightData, light);
+        vec4 colorLinear = texelFetch(lightData, light + 1);
+        float quadratic = texelFetch(lightData, light + 2).r;
+        // calculate distance between light source and current fragment
+        float distance = length(positionRadius.xyz - FragPos);
+        if(distance < positionRadius.w)
+        {
+            // diffuse
+            vec3 lightDir = normalize(positionRadius.xyz - FragPos);
+            vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Diffuse * colorLinear.rgb;
+            // specular
+            vec3 halfwayDir = normalize(lightDir + viewDir);  
+            float spec = pow(max(dot(Normal, halfwayDir), 0.0), 16.0);
+            vec3 specular = colorLinear.rgb * spec * Specular;
+            // attenuation
+            float attenuation = 1.0 / (1.0 + colorLinear.a * distance + quadratic * distance * distance);
+            diffuse *= attenuation;
+            specular *= attenuation;
+            lighting += diffuse + specular;
+        }
+    }    
+    FragColor = vec4(lighting, 1.0);
+}
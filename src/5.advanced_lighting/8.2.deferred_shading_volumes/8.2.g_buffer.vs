@@ -7,9 +7,9 @@ out vec3 FragPos;
 out vec2 TexCoords;
 out vec3 Normal;
 
+#include "frame_data.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
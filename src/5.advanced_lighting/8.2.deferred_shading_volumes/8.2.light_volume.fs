@@ -0,0 +1,44 @@
+#version 330 core
+out vec4 FragColor;
+
+flat in vec4 PositionRadius;
+flat in vec4 ColorLinear;
+flat in float Quadratic;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+
+#include "frame_data.glsl"
+
+void main()
+{             
+    // retrieve data from gbuffer at the pixel the light volume covers
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 FragPos = texelFetch(gPosition, pixel, 0).rgb;
+    vec3 Normal = texelFetch(gNormal, pixel, 0).rgb;
+    vec3 Diffuse = texelFetch(gAlbedoSpec, pixel, 0).rgb;
+    float Specular = texelFetch(gAlbedoSpec, pixel, 0).a;
+    
+    // then calculate this light's share of the lighting as usual; ambient is added by the full screen ambient pass
+    vec3 lighting = vec3(0.0);
+    vec3 viewDir  = normalize(cameraPosition - FragPos);
+    // calculate distance between light source and current fragment
+    float distance = length(PositionRadius.xyz - FragPos);
+    if(distance < PositionRadius.w)
+    {
+        // diffuse
+        vec3 lightDir = normalize(PositionRadius.xyz - FragPos);
+        vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Diffuse * ColorLinear.rgb;
+        // specular
+        vec3 halfwayDir = normalize(lightDir + viewDir);  
+        float spec = pow(max(dot(Normal, halfwayDir), 0.0), 16.0);
+        vec3 specular = ColorLinear.rgb * spec * Specular;
+        // attenuation
+        float attenuation = 1.0 / (1.0 + ColorLinear.a * distance + Quadratic * distance * distance);
+        diffuse *= attenuation;
+        specular *= attenuation;
+        lighting += diffuse + specular;
+    }
+    FragColor = vec4(lighting, 1.0);
+}
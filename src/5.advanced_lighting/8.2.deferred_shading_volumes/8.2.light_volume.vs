@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+// the light of this instance
+layout (location = 1) in vec4 aPositionRadius;
+layout (location = 2) in vec4 aColorLinear;
+layout (location = 3) in float aQuadratic;
+
+flat out vec4 PositionRadius;
+flat out vec4 ColorLinear;
+flat out float Quadratic;
+
+#include "frame_data.glsl"
+
+void main()
+{
+    PositionRadius = aPositionRadius;
+    ColorLinear = aColorLinear;
+    Quadratic = aQuadratic;
+    // the unit sphere scaled to the light's radius
+    gl_Position = projection * view * vec4(aPositionRadius.xyz + aPos * aPositionRadius.w, 1.0);
+}
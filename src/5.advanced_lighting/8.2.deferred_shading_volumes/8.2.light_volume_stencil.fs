@@ -0,0 +1,6 @@
+#version 330 core
+
+// the stencil pass only counts the light volumes in the stencil buffer, there's no color to write
+void main()
+{
+}
@@ -7,10 +7,18 @@
 
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/shader_batch.h>
+#include <learnopengl/shader_watcher.h>
+#include <learnopengl/frame_data.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/profiler.h>
+#include <learnopengl/light_clusters.h>
+#include <learnopengl/light_volumes.h>
 
 #include <iostream>
+#include <cstdlib>
+#include <cmath>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -34,8 +42,47 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+// lighting pass: every light at every pixel of a full screen quad, only the lights of each pixel's cluster, or a sphere
+// per light covering just the pixels it reaches
+enum LightingMode
 {
+    LIGHTING_FULL_SCREEN,
+    LIGHTING_CLUSTERED,
+    LIGHTING_VOLUMES,
+    LIGHTING_MODES
+};
+const char *lightingModeNames[LIGHTING_MODES] = { "full screen", "clustered", "volumes" };
+LightingMode lightingMode = LIGHTING_CLUSTERED;
+bool lightingModeKeyPressed = false;
+
+int main(int argc, char *argv[])
+{
+    // --lights N shades the scene with N lights instead of 32
+    // --lighting full_screen|clustered|volumes picks the lighting pass to start with
+    // --compare switches the lighting pass every frame, so the profiler's report compares all three on the same run
+    unsigned int lightCount = 32;
+    bool compare = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--lights" && i + 1 < argc)
+            lightCount = std::max(std::atoi(argv[++i]), 1);
+        else if (arg == "--lighting" && i + 1 < argc)
+        {
+            std::string mode = argv[++i];
+            if (mode == "full_screen")
+                lightingMode = LIGHTING_FULL_SCREEN;
+            else if (mode == "clustered")
+                lightingMode = LIGHTING_CLUSTERED;
+            else if (mode == "volumes")
+                lightingMode = LIGHTING_VOLUMES;
+            else
+                std::cout << "unknown lighting pass " << mode << ", use full_screen, clustered or volumes" << std::endl;
+        }
+        else if (arg == "--compare")
+            compare = true;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -79,22 +126,31 @@ int main()
     // build and compile shaders
     // -------------------------
     Shader shaderGeometryPass("8.2.g_buffer.vs", "8.2.g_buffer.fs");
-    Shader shaderLightingPass("8.2.deferred_shading.vs", "8.2.deferred_shading.fs");
+    // the full screen quad shader is compiled for exactly the lights it shades, it has room for 32 at most
+    const unsigned int NR_LIGHTS = std::min(lightCount, 32u);
+    ShaderDefines lightingDefines;
+    lightingDefines["NR_LIGHTS"] = std::to_string(NR_LIGHTS);
+    Shader shaderLightingPass("8.2.deferred_shading.vs", "8.2.deferred_shading.fs", lightingDefines);
+    // the clustered and light volume passes compile in the background, until theirs are ready the full screen pass
+    // stands in for them
+    ShaderBatch lightingShaders;
+    Shader shaderClusteredLightingPass = lightingShaders.add("8.2.deferred_shading.vs", "8.2.deferred_shading_clustered.fs");
+    Shader shaderAmbientPass = lightingShaders.add("8.2.deferred_shading.vs", "8.2.deferred_ambient.fs");
+    Shader shaderLightVolumeStencil = lightingShaders.add("8.2.light_volume.vs", "8.2.light_volume_stencil.fs");
+    Shader shaderLightVolume = lightingShaders.add("8.2.light_volume.vs", "8.2.light_volume.fs");
     Shader shaderLightBox("8.2.deferred_light_box.vs", "8.2.deferred_light_box.fs");
 
     // load models
     // -----------
     Model nanosuit(FileSystem::getPath("resources/objects/nanosuit/nanosuit.obj"));
+    // the scene grows with the number of lights so the lights per area stay the same: a 3x3 grid of nanosuits for 32
+    // lights, 6x6 for up to 128 and so on
+    const unsigned int spread = (unsigned int)std::ceil(std::sqrt(lightCount / 32.0f));
+    const unsigned int gridSide = 3 * spread;
     std::vector<glm::vec3> objectPositions;
-    objectPositions.push_back(glm::vec3(-3.0,  -3.0, -3.0));
-    objectPositions.push_back(glm::vec3( 0.0,  -3.0, -3.0));
-    objectPositions.push_back(glm::vec3( 3.0,  -3.0, -3.0));
-    objectPositions.push_back(glm::vec3(-3.0,  -3.0,  0.0));
-    objectPositions.push_back(glm::vec3( 0.0,  -3.0,  0.0));
-    objectPositions.push_back(glm::vec3( 3.0,  -3.0,  0.0));
-    objectPositions.push_back(glm::vec3(-3.0,  -3.0,  3.0));
-    objectPositions.push_back(glm::vec3( 0.0,  -3.0,  3.0));
-    objectPositions.push_back(glm::vec3( 3.0,  -3.0,  3.0));
+    for (unsigned int z = 0; z < gridSide; z++)
+        for (unsigned int x = 0; x < gridSide; x++)
+            objectPositions.push_back(glm::vec3((x - (gridSide - 1) * 0.5f) * 3.0f, -3.0f, (z - (gridSide - 1) * 0.5f) * 3.0f));
 
 
     // configure g-buffer framebuffer
@@ -127,43 +183,99 @@ int main()
     // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
     unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
     glDrawBuffers(3, attachments);
-    // create and attach depth buffer (renderbuffer)
+    // create and attach depth buffer (renderbuffer), with a stencil buffer for culling the light volumes
     unsigned int rboDepth;
     glGenRenderbuffers(1, &rboDepth);
     glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
     // finally check if framebuffer is complete
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Framebuffer not complete!" << std::endl;
+
+    // configure lighting framebuffer: the light volumes add up in a floating point color buffer and are tested
+    // against the g-buffer's depth, so it shares the g-buffer's depth and stencil renderbuffer
+    // ---------------------------------------------------------------------------------------------------------
+    unsigned int lightingFBO, lightingBuffer;
+    glGenFramebuffers(1, &lightingFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, lightingFBO);
+    glGenTextures(1, &lightingBuffer);
+    glBindTexture(GL_TEXTURE_2D, lightingBuffer);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lightingBuffer, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "Framebuffer not complete!" << std::endl;
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // lighting info
     // -------------
-    const unsigned int NR_LIGHTS = 32;
-    std::vector<glm::vec3> lightPositions;
-    std::vector<glm::vec3> lightColors;
+    // more lights than fit in the full screen quad shader need the clustered or light volume pass
+    if (lightCount > NR_LIGHTS)
+        std::cout << "more than " << NR_LIGHTS << " lights, the full screen quad lighting pass only shades the first " << NR_LIGHTS << std::endl;
+    std::vector<PointLight> lights;
     srand(13);
-    for (unsigned int i = 0; i < NR_LIGHTS; i++)
+    for (unsigned int i = 0; i < lightCount; i++)
     {
+        PointLight light;
         // calculate slightly random offsets
-        float xPos = ((rand() % 100) / 100.0) * 6.0 - 3.0;
+        float xPos = (((rand() % 100) / 100.0) * 6.0 - 3.0) * spread;
         float yPos = ((rand() % 100) / 100.0) * 6.0 - 4.0;
-        float zPos = ((rand() % 100) / 100.0) * 6.0 - 3.0;
-        lightPositions.push_back(glm::vec3(xPos, yPos, zPos));
+        float zPos = (((rand() % 100) / 100.0) * 6.0 - 3.0) * spread;
+        light.Position = glm::vec3(xPos, yPos, zPos);
         // also calculate random color
         float rColor = ((rand() % 100) / 200.0f) + 0.5; // between 0.5 and 1.0
         float gColor = ((rand() % 100) / 200.0f) + 0.5; // between 0.5 and 1.0
         float bColor = ((rand() % 100) / 200.0f) + 0.5; // between 0.5 and 1.0
-        lightColors.push_back(glm::vec3(rColor, gColor, bColor));
+        light.Color = glm::vec3(rColor, gColor, bColor);
+        // attenuation parameters and the radius of the light volume/sphere
+        const float constant = 1.0; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
+        light.Linear = 0.7;
+        light.Quadratic = 1.8;
+        const float maxBrightness = std::fmaxf(std::fmaxf(light.Color.r, light.Color.g), light.Color.b);
+        light.Radius = (-light.Linear + std::sqrt(light.Linear * light.Linear - 4 * light.Quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * light.Quadratic);
+        lights.push_back(light);
     }
 
+    // clustered light culling: a 16x9x24 grid of froxels over the view frustum, each with the list of lights reaching it
+    // ------------------------------------------------------------------------------------------------------------------
+    LightClusters lightClusters;
+    // the froxel bounds only depend on the projection, which changes with the camera's zoom (the g-buffer and the
+    // projection stay at SCR_WIDTH x SCR_HEIGHT when the window is resized)
+    float clusterZoom = camera.Zoom;
+    lightClusters.setProjection(glm::radians(clusterZoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f, SCR_WIDTH, SCR_HEIGHT);
+
+    // light volumes: an instanced sphere per light, stencil culled and blended additively into the lighting framebuffer
+    // -----------------------------------------------------------------------------------------------------------------
+    LightVolumes lightVolumes(shaderLightVolumeStencil, shaderLightVolume);
+    lightVolumes.update(lights);
+
     // shader configuration
     // --------------------
     shaderLightingPass.use();
     shaderLightingPass.setInt("gPosition", 0);
     shaderLightingPass.setInt("gNormal", 1);
     shaderLightingPass.setInt("gAlbedoSpec", 2);
+    // resolve the light uniforms once instead of building their names every frame
+    std::vector<Shader::UniformHandle> lightPositionHandles, lightColorHandles, lightLinearHandles, lightQuadraticHandles, lightRadiusHandles;
+    for (unsigned int i = 0; i < NR_LIGHTS; i++)
+    {
+        std::string light = "lights[" + std::to_string(i) + "]";
+        lightPositionHandles.push_back(shaderLightingPass.uniformHandle(light + ".Position"));
+        lightColorHandles.push_back(shaderLightingPass.uniformHandle(light + ".Color"));
+        lightLinearHandles.push_back(shaderLightingPass.uniformHandle(light + ".Linear"));
+        lightQuadraticHandles.push_back(shaderLightingPass.uniformHandle(light + ".Quadratic"));
+        lightRadiusHandles.push_back(shaderLightingPass.uniformHandle(light + ".Radius"));
+    }
+    // comparing the lighting passes needs all of them from the first frame
+    if (compare)
+        lightingShaders.wait();
+
+    // per pass CPU and GPU timings, reported when the demo exits
+    // ----------------------------------------------------------
+    Profiler profiler;
 
     // render loop
     // -----------
@@ -178,22 +290,33 @@ int main()
         // input
         // -----
         processInput(window);
+        // rebuild the shaders edited since the last frame
+        ShaderWatcher::shared().update();
+        if (compare)
+            lightingMode = (LightingMode)((lightingMode + 1) % LIGHTING_MODES);
+        lightingShaders.poll();
+        LightingMode mode = lightingMode;
+        if ((mode == LIGHTING_CLUSTERED && !shaderClusteredLightingPass.ready()) ||
+            (mode == LIGHTING_VOLUMES && !(shaderAmbientPass.ready() && shaderLightVolumeStencil.ready() && shaderLightVolume.ready())))
+            mode = LIGHTING_FULL_SCREEN;
 
         // render
         // ------
+        // the camera of this frame, shared by every pass through the FrameData block
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+        FrameData::shared().update(view, projection, camera.Position, currentFrame, SCR_WIDTH, SCR_HEIGHT);
+        profiler.beginFrame();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
+        profiler.begin("geometry");
         glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
         glm::mat4 model = glm::mat4(1.0f);
         shaderGeometryPass.use();
-        shaderGeometryPass.setMat4("projection", projection);
-        shaderGeometryPass.setMat4("view", view);
         for (unsigned int i = 0; i < objectPositions.size(); i++)
         {
             model = glm::mat4(1.0f);
@@ -203,39 +326,83 @@ int main()
             nanosuit.Draw(shaderGeometryPass);
         }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
         // 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content.
         // -----------------------------------------------------------------------------------------------------------------------
+        if (mode == LIGHTING_CLUSTERED)
+        {
+            if (camera.Zoom != clusterZoom)
+            {
+                clusterZoom = camera.Zoom;
+                lightClusters.setProjection(glm::radians(clusterZoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f, SCR_WIDTH, SCR_HEIGHT);
+            }
+            // assign the lights to the froxels they reach on the CPU
+            profiler.begin("light culling");
+            lightClusters.update(view, lights);
+            profiler.end();
+        }
+        profiler.begin(std::string("lighting ") + lightingModeNames[mode]);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shaderLightingPass.use();
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, gPosition);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, gNormal);
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-        // send light relevant uniforms
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
+        if (mode == LIGHTING_VOLUMES)
+        {
+            // ambient for every pixel, then each light volume adds its light on top
+            glBindFramebuffer(GL_FRAMEBUFFER, lightingFBO);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glDisable(GL_DEPTH_TEST);
+            shaderAmbientPass.use();
+            shaderAmbientPass.setInt("gAlbedoSpec", 2);
+            renderQuad();
+            shaderLightVolume.use();
+            shaderLightVolume.setInt("gPosition", 0);
+            shaderLightVolume.setInt("gNormal", 1);
+            shaderLightVolume.setInt("gAlbedoSpec", 2);
+            lightVolumes.draw();
+            // copy the result to the default framebuffer
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, lightingFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+        else
         {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
-            // update attenuation parameters and calculate radius
-            const float constant = 1.0; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
-            const float linear = 0.7;
-            const float quadratic = 1.8;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
-            // then calculate radius of light volume/sphere
-            const float maxBrightness = std::fmaxf(std::fmaxf(lightColors[i].r, lightColors[i].g), lightColors[i].b);
-            float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Radius", radius);
+            Shader &lightingPass = mode == LIGHTING_CLUSTERED ? shaderClusteredLightingPass : shaderLightingPass;
+            lightingPass.use();
+            if (mode == LIGHTING_CLUSTERED)
+            {
+                // the sampler units are set here since the program may only have become ready this frame; the
+                // uniform cache skips them after that
+                shaderClusteredLightingPass.setInt("gPosition", 0);
+                shaderClusteredLightingPass.setInt("gNormal", 1);
+                shaderClusteredLightingPass.setInt("gAlbedoSpec", 2);
+                lightClusters.bind(shaderClusteredLightingPass, 3);
+            }
+            else
+            {
+                // send light relevant uniforms
+                for (unsigned int i = 0; i < lights.size() && i < NR_LIGHTS; i++)
+                {
+                    shaderLightingPass.setVec3(lightPositionHandles[i], lights[i].Position);
+                    shaderLightingPass.setVec3(lightColorHandles[i], lights[i].Color);
+                    shaderLightingPass.setFloat(lightLinearHandles[i], lights[i].Linear);
+                    shaderLightingPass.setFloat(lightQuadraticHandles[i], lights[i].Quadratic);
+                    shaderLightingPass.setFloat(lightRadiusHandles[i], lights[i].Radius);
+                }
+            }
+            // finally render quad
+            renderQuad();
         }
-        shaderLightingPass.setVec3("viewPos", camera.Position);
-        // finally render quad
-        renderQuad();
+        profiler.end();
 
         // 2.5. copy content of geometry's depth buffer to default framebuffer's depth buffer
         // ----------------------------------------------------------------------------------
+        profiler.begin("depth copy");
         glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
         // blit to default framebuffer. Note that this may or may not work as the internal formats of both the FBO and default framebuffer have to match.
@@ -243,21 +410,24 @@ int main()
         // depth buffer in another shader stage (or somehow see to match the default framebuffer's internal format with the FBO's internal format).
         glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
         // 3. render lights on top of scene
         // --------------------------------
+        profiler.begin("light boxes");
         shaderLightBox.use();
-        shaderLightBox.setMat4("projection", projection);
-        shaderLightBox.setMat4("view", view);
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
+        for (unsigned int i = 0; i < lights.size(); i++)
         {
             model = glm::mat4(1.0f);
-            model = glm::translate(model, lightPositions[i]);
+            model = glm::translate(model, lights[i].Position);
             model = glm::scale(model, glm::vec3(0.125f));
             shaderLightBox.setMat4("model", model);
-            shaderLightBox.setVec3("lightColor", lightColors[i]);
+            shaderLightBox.setVec3("lightColor", lights[i].Color);
             renderCube();
         }
+        profiler.end();
+        profiler.endFrame();
+        RenderState::shared().endFrame();
 
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -266,6 +436,14 @@ int main()
         glfwPollEvents();
     }
 
+    profiler.report(std::cout);
+    std::cout << lightCount << " lights, " << lightClusters.lightReferences << " cluster light references, at most "
+              << lightClusters.maxLightsPerCluster << " lights per cluster" << std::endl;
+    // GL state changes of the last frame, issued to the driver or filtered as redundant
+    RenderState::shared().report(std::cout);
+    profiler.writeCSV("8.2.deferred_shading_volumes.profile.csv");
+    profiler.writeChromeTrace("8.2.deferred_shading_volumes.trace.json");
+
     glfwTerminate();
     return 0;
 }
@@ -392,6 +570,15 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS && !lightingModeKeyPressed)
+    {
+        lightingMode = (LightingMode)((lightingMode + 1) % LIGHTING_MODES);
+        lightingModeKeyPressed = true;
+        std::cout << lightingModeNames[lightingMode] << " lighting" << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE)
+        lightingModeKeyPressed = false;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
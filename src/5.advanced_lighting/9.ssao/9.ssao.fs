@@ -7,10 +7,14 @@ uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D texNoise;
 
-uniform vec3 samples[64];
+// the kernel size is defined by the demo when it builds the shader, so the sample loop has a constant trip count
+#ifndef KERNEL_SIZE
+#define KERNEL_SIZE 64
+#endif
+uniform vec3 samples[KERNEL_SIZE];
 
 // parameters (you'd probably want to use them as uniforms to more easily tweak the effect)
-int kernelSize = 64;
+const int kernelSize = KERNEL_SIZE;
 float radius = 0.5;
 float bias = 0.025;
 
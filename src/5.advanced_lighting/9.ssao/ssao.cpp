@@ -9,6 +9,7 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/profiler.h>
 
 #include <iostream>
 #include <random>
@@ -24,6 +25,8 @@ void renderCube();
 // settings
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
+// samples in the SSAO kernel, compiled into the SSAO shader
+const unsigned int KERNEL_SIZE = 64;
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
@@ -86,7 +89,9 @@ int main()
     // -------------------------
     Shader shaderGeometryPass("9.ssao_geometry.vs", "9.ssao_geometry.fs");
     Shader shaderLightingPass("9.ssao.vs", "9.ssao_lighting.fs");
-    Shader shaderSSAO("9.ssao.vs", "9.ssao.fs");
+    ShaderDefines ssaoDefines;
+    ssaoDefines["KERNEL_SIZE"] = std::to_string(KERNEL_SIZE);
+    Shader shaderSSAO("9.ssao.vs", "9.ssao.fs", ssaoDefines);
     Shader shaderSSAOBlur("9.ssao.vs", "9.ssao_blur.fs");
 
     // load models
@@ -168,12 +173,12 @@ int main()
     std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
     std::default_random_engine generator;
     std::vector<glm::vec3> ssaoKernel;
-    for (unsigned int i = 0; i < 64; ++i)
+    for (unsigned int i = 0; i < KERNEL_SIZE; ++i)
     {
         glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
         sample = glm::normalize(sample);
         sample *= randomFloats(generator);
-        float scale = float(i) / 64.0;
+        float scale = float(i) / KERNEL_SIZE;
 
         // scale samples s.t. they're more aligned to center of kernel
         scale = lerp(0.1f, 1.0f, scale * scale);
@@ -216,6 +221,10 @@ int main()
     shaderSSAOBlur.use();
     shaderSSAOBlur.setInt("ssaoInput", 0);
 
+    // per pass CPU and GPU timings, reported when the demo exits
+    // ----------------------------------------------------------
+    Profiler profiler;
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -232,11 +241,13 @@ int main()
 
         // render
         // ------
+        profiler.beginFrame();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
+        profiler.begin("geometry");
         glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 50.0f);
@@ -261,15 +272,17 @@ int main()
             shaderGeometryPass.setMat4("model", model);
             nanosuit.Draw(shaderGeometryPass);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
 
         // 2. generate SSAO texture
         // ------------------------
+        profiler.begin("ssao");
         glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
             glClear(GL_COLOR_BUFFER_BIT);
             shaderSSAO.use();
             // Send kernel + rotation 
-            for (unsigned int i = 0; i < 64; ++i)
+            for (unsigned int i = 0; i < KERNEL_SIZE; ++i)
                 shaderSSAO.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
             shaderSSAO.setMat4("projection", projection);
             glActiveTexture(GL_TEXTURE0);
@@ -280,10 +293,12 @@ int main()
             glBindTexture(GL_TEXTURE_2D, noiseTexture);
             renderQuad();
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
 
         // 3. blur SSAO texture to remove noise
         // ------------------------------------
+        profiler.begin("blur");
         glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
             glClear(GL_COLOR_BUFFER_BIT);
             shaderSSAOBlur.use();
@@ -291,10 +306,12 @@ int main()
             glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
             renderQuad();
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end();
 
 
         // 4. lighting pass: traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion
         // -----------------------------------------------------------------------------------------------------
+        profiler.begin("lighting");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shaderLightingPass.use();
         // send light relevant uniforms
@@ -316,6 +333,9 @@ int main()
         glActiveTexture(GL_TEXTURE3); // add extra SSAO texture to lighting pass
         glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
         renderQuad();
+        profiler.end();
+        profiler.endFrame();
+        RenderState::shared().endFrame();
 
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -324,6 +344,12 @@ int main()
         glfwPollEvents();
     }
 
+    profiler.report(std::cout);
+    // GL state changes of the last frame, issued to the driver or filtered as redundant
+    RenderState::shared().report(std::cout);
+    profiler.writeCSV("9.ssao.profile.csv");
+    profiler.writeChromeTrace("9.ssao.trace.json");
+
     glfwTerminate();
     return 0;
 }
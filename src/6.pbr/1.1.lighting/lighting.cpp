@@ -109,6 +109,10 @@ int main()
     shader.use();
     shader.setMat4("projection", projection);
 
+    // the spheres are queued and drawn front to back
+    // ----------------------------------------------
+    RenderQueue renderQueue;
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -134,15 +138,17 @@ int main()
         shader.setVec3("camPos", camera.Position);
 
         // render rows*column number of spheres with varying metallic/roughness values scaled by rows and columns respectively
+        renderQueue.setView(camera.Position, camera.Front, 0.1f, 100.0f);
         glm::mat4 model = glm::mat4(1.0f);
+        float metallic = 0.0f, roughness = 0.0f;
         for (int row = 0; row < nrRows; ++row) 
         {
-            shader.setFloat("metallic", (float)row / (float)nrRows);
+            metallic = (float)row / (float)nrRows;
             for (int col = 0; col < nrColumns; ++col) 
             {
                 // we clamp the roughness to 0.025 - 1.0 as perfectly smooth surfaces (roughness of 0.0) tend to look a bit off
                 // on direct lighting.
-                shader.setFloat("roughness", glm::clamp((float)col / (float)nrColumns, 0.05f, 1.0f));
+                roughness = glm::clamp((float)col / (float)nrColumns, 0.05f, 1.0f);
                 
                 model = glm::mat4(1.0f);
                 model = glm::translate(model, glm::vec3(
@@ -150,8 +156,13 @@ int main()
                     (row - (nrRows / 2)) * spacing, 
                     0.0f
                 ));
-                shader.setMat4("model", model);
-                renderSphere();
+                // the queue sets the model matrix, the sphere sets its material when its turn comes
+                renderQueue.submit(shader, 0, 0, glm::vec3(model[3]), model, [metallic, roughness](const Shader &shader)
+                {
+                    shader.setFloat("metallic", metallic);
+                    shader.setFloat("roughness", roughness);
+                    renderSphere();
+                });
             }
         }
 
@@ -168,9 +179,15 @@ int main()
             model = glm::mat4(1.0f);
             model = glm::translate(model, newPos);
             model = glm::scale(model, glm::vec3(0.5f));
-            shader.setMat4("model", model);
-            renderSphere();
+            // with the material of the grid's last sphere
+            renderQueue.submit(shader, 0, 0, newPos, model, [metallic, roughness](const Shader &shader)
+            {
+                shader.setFloat("metallic", metallic);
+                shader.setFloat("roughness", roughness);
+                renderSphere();
+            });
         }
+        renderQueue.flush();
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
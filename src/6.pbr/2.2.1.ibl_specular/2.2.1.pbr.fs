@@ -19,7 +19,7 @@ uniform sampler2D brdfLUT;
 uniform vec3 lightPositions[4];
 uniform vec3 lightColors[4];
 
-uniform vec3 camPos;
+#include "frame_data.glsl"
 
 const float PI = 3.14159265359;
 // ----------------------------------------------------------------------------
@@ -71,7 +71,7 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 void main()
 {		
     vec3 N = Normal;
-    vec3 V = normalize(camPos - WorldPos);
+    vec3 V = normalize(cameraPosition - WorldPos);
     vec3 R = reflect(-V, N); 
 
     // calculate reflectance at normal incidence; if dia-electric (like plastic) use F0 
@@ -7,8 +7,8 @@ out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
 
-uniform mat4 projection;
-uniform mat4 view;
+#include "frame_data.glsl"
+
 uniform mat4 model;
 
 void main()
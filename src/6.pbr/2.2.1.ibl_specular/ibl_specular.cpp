@@ -8,8 +8,12 @@
 
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/shader_batch.h>
+#include <learnopengl/shader_watcher.h>
+#include <learnopengl/frame_data.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/profiler.h>
 
 #include <iostream>
 
@@ -82,24 +86,16 @@ int main()
     // enable seamless cubemap sampling for lower mip levels in the pre-filter map.
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
-    // build and compile shaders
-    // -------------------------
-    Shader pbrShader("2.2.1.pbr.vs", "2.2.1.pbr.fs");
-    Shader equirectangularToCubemapShader("2.2.1.cubemap.vs", "2.2.1.equirectangular_to_cubemap.fs");
-    Shader irradianceShader("2.2.1.cubemap.vs", "2.2.1.irradiance_convolution.fs");
-    Shader prefilterShader("2.2.1.cubemap.vs", "2.2.1.prefilter.fs");
-    Shader brdfShader("2.2.1.brdf.vs", "2.2.1.brdf.fs");
-    Shader backgroundShader("2.2.1.background.vs", "2.2.1.background.fs");
-
-    pbrShader.use();
-    pbrShader.setInt("irradianceMap", 0);
-    pbrShader.setInt("prefilterMap", 1);
-    pbrShader.setInt("brdfLUT", 2);
-    pbrShader.setVec3("albedo", 0.5f, 0.0f, 0.0f);
-    pbrShader.setFloat("ao", 1.0f);
-
-    backgroundShader.use();
-    backgroundShader.setInt("environmentMap", 0);
+    // build and compile shaders: all six are submitted at once and compile while the environment map loads, each
+    // precomputation pass only waits for its own program when it first uses it
+    // -------------------------------------------------------------------------------------------------------------
+    ShaderBatch shaders;
+    Shader pbrShader = shaders.add("2.2.1.pbr.vs", "2.2.1.pbr.fs");
+    Shader equirectangularToCubemapShader = shaders.add("2.2.1.cubemap.vs", "2.2.1.equirectangular_to_cubemap.fs");
+    Shader irradianceShader = shaders.add("2.2.1.cubemap.vs", "2.2.1.irradiance_convolution.fs");
+    Shader prefilterShader = shaders.add("2.2.1.cubemap.vs", "2.2.1.prefilter.fs");
+    Shader brdfShader = shaders.add("2.2.1.brdf.vs", "2.2.1.brdf.fs");
+    Shader backgroundShader = shaders.add("2.2.1.background.vs", "2.2.1.background.fs");
 
   
     // lights
@@ -184,8 +180,13 @@ int main()
         glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
     };
 
+    // per pass CPU and GPU timings of the precomputation and every frame, reported when the demo exits
+    // -----------------------------------------------------------------------------------------------
+    Profiler profiler;
+
     // pbr: convert HDR equirectangular environment map to cubemap equivalent
     // ----------------------------------------------------------------------
+    profiler.begin("equirect to cubemap");
     equirectangularToCubemapShader.use();
     equirectangularToCubemapShader.setInt("equirectangularMap", 0);
     equirectangularToCubemapShader.setMat4("projection", captureProjection);
@@ -207,6 +208,7 @@ int main()
     // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
     glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    profiler.end();
 
     // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
     // --------------------------------------------------------------------------------
@@ -229,6 +231,7 @@ int main()
 
     // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
     // -----------------------------------------------------------------------------
+    profiler.begin("irradiance");
     irradianceShader.use();
     irradianceShader.setInt("environmentMap", 0);
     irradianceShader.setMat4("projection", captureProjection);
@@ -246,6 +249,7 @@ int main()
         renderCube();
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    profiler.end();
 
     // pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
     // --------------------------------------------------------------------------------
@@ -266,6 +270,7 @@ int main()
 
     // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
     // ----------------------------------------------------------------------------------------------------
+    profiler.begin("prefilter");
     prefilterShader.use();
     prefilterShader.setInt("environmentMap", 0);
     prefilterShader.setMat4("projection", captureProjection);
@@ -295,6 +300,7 @@ int main()
         }
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    profiler.end();
 
     // pbr: generate a 2D LUT from the BRDF equations used.
     // ----------------------------------------------------
@@ -316,21 +322,30 @@ int main()
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
 
+    profiler.begin("brdf lut");
     glViewport(0, 0, 512, 512);
     brdfShader.use();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     renderQuad();
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    profiler.end();
 
 
     // initialize static shader uniforms before rendering
     // --------------------------------------------------
     glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
     pbrShader.use();
-    pbrShader.setMat4("projection", projection);
+    pbrShader.setInt("irradianceMap", 0);
+    pbrShader.setInt("prefilterMap", 1);
+    pbrShader.setInt("brdfLUT", 2);
+    pbrShader.setVec3("albedo", 0.5f, 0.0f, 0.0f);
+    pbrShader.setFloat("ao", 1.0f);
     backgroundShader.use();
-    backgroundShader.setMat4("projection", projection);
+    backgroundShader.setInt("environmentMap", 0);
+    // every program is built by now; they come from the binary cache after the first run
+    shaders.wait();
+    ProgramCache::shared().report(std::cout);
 
     // then before rendering, configure the viewport to the original framebuffer's screen dimensions
     int scrWidth, scrHeight;
@@ -350,18 +365,21 @@ int main()
         // input
         // -----
         processInput(window);
+        // rebuild the shaders edited since the last frame
+        ShaderWatcher::shared().update();
 
         // render
         // ------
+        // the camera of this frame, shared by the spheres and the background through the FrameData block
+        FrameData::shared().update(camera.GetViewMatrix(), projection, camera.Position, currentFrame, SCR_WIDTH, SCR_HEIGHT);
+        profiler.beginFrame();
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // render scene, supplying the convoluted irradiance map to the final shader.
         // ------------------------------------------------------------------------------------------
+        profiler.begin("spheres");
         pbrShader.use();
-        glm::mat4 view = camera.GetViewMatrix();
-        pbrShader.setMat4("view", view);
-        pbrShader.setVec3("camPos", camera.Position);
 
         // bind pre-computed IBL data
         glActiveTexture(GL_TEXTURE0);
@@ -411,14 +429,18 @@ int main()
             renderSphere();
         }
 
+        profiler.end();
+
         // render skybox (render as last to prevent overdraw)
+        profiler.begin("skybox");
         backgroundShader.use();
-        backgroundShader.setMat4("view", view);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
         //glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap); // display irradiance map
         //glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap); // display prefilter map
         renderCube();
+        profiler.end();
+        profiler.endFrame();
 
 
         // render BRDF map to screen
@@ -432,6 +454,10 @@ int main()
         glfwPollEvents();
     }
 
+    profiler.report(std::cout);
+    profiler.writeCSV("2.2.1.ibl_specular.profile.csv");
+    profiler.writeChromeTrace("2.2.1.ibl_specular.trace.json");
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
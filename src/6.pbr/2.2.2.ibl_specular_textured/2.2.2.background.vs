@@ -1,8 +1,7 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 projection;
-uniform mat4 view;
+#include "frame_data.glsl"
 
 out vec3 WorldPos;
 
@@ -8,8 +8,12 @@
 
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/shader_watcher.h>
+#include <learnopengl/frame_data.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/profiler.h>
+#include <learnopengl/texture_cache.h>
 
 #include <iostream>
 
@@ -91,6 +95,8 @@ int main()
     Shader prefilterShader("2.2.2.cubemap.vs", "2.2.2.prefilter.fs");
     Shader brdfShader("2.2.2.brdf.vs", "2.2.2.brdf.fs");
     Shader backgroundShader("2.2.2.background.vs", "2.2.2.background.fs");
+    // the programs come from the binary cache after the first run
+    ProgramCache::shared().report(std::cout);
 
     pbrShader.use();
     pbrShader.setInt("irradianceMap", 0);
@@ -174,6 +180,8 @@ int main()
 
     // pbr: load the HDR environment map
     // ---------------------------------
+    // the material textures above are decoded with the current flip setting, so wait for them before changing it
+    TextureLoader::shared().finish();
     stbi_set_flip_vertically_on_load(true);
     int width, height, nrComponents;
     float *data = stbi_loadf(FileSystem::getPath("resources/textures/hdr/newport_loft.hdr").c_str(), &width, &height, &nrComponents, 0);
@@ -224,8 +232,13 @@ int main()
         glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
     };
 
+    // per pass CPU and GPU timings of the precomputation and every frame, reported when the demo exits
+    // -----------------------------------------------------------------------------------------------
+    Profiler profiler;
+
     // pbr: convert HDR equirectangular environment map to cubemap equivalent
     // ----------------------------------------------------------------------
+    profiler.begin("equirect to cubemap");
     equirectangularToCubemapShader.use();
     equirectangularToCubemapShader.setInt("equirectangularMap", 0);
     equirectangularToCubemapShader.setMat4("projection", captureProjection);
@@ -247,6 +260,7 @@ int main()
     // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
     glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    profiler.end();
 
     // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
     // --------------------------------------------------------------------------------
@@ -269,6 +283,7 @@ int main()
 
     // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
     // -----------------------------------------------------------------------------
+    profiler.begin("irradiance");
     irradianceShader.use();
     irradianceShader.setInt("environmentMap", 0);
     irradianceShader.setMat4("projection", captureProjection);
@@ -286,6 +301,7 @@ int main()
         renderCube();
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    profiler.end();
 
     // pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
     // --------------------------------------------------------------------------------
@@ -306,6 +322,7 @@ int main()
 
     // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
     // ----------------------------------------------------------------------------------------------------
+    profiler.begin("prefilter");
     prefilterShader.use();
     prefilterShader.setInt("environmentMap", 0);
     prefilterShader.setMat4("projection", captureProjection);
@@ -335,6 +352,7 @@ int main()
         }
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    profiler.end();
 
     // pbr: generate a 2D LUT from the BRDF equations used.
     // ----------------------------------------------------
@@ -356,21 +374,19 @@ int main()
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
 
+    profiler.begin("brdf lut");
     glViewport(0, 0, 512, 512);
     brdfShader.use();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     renderQuad();
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    profiler.end();
 
 
-    // initialize static shader uniforms before rendering
-    // --------------------------------------------------
+    // the projection the FrameData block gets every frame
+    // ---------------------------------------------------
     glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    pbrShader.use();
-    pbrShader.setMat4("projection", projection);
-    backgroundShader.use();
-    backgroundShader.setMat4("projection", projection);
 
     // then before rendering, configure the viewport to the original framebuffer's screen dimensions
     int scrWidth, scrHeight;
@@ -390,19 +406,22 @@ int main()
         // input
         // -----
         processInput(window);
+        // rebuild the shaders edited since the last frame
+        ShaderWatcher::shared().update();
 
         // render
         // ------
+        // the camera of this frame, shared by the spheres and the background through the FrameData block
+        FrameData::shared().update(camera.GetViewMatrix(), projection, camera.Position, currentFrame, SCR_WIDTH, SCR_HEIGHT);
+        profiler.beginFrame();
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // render scene, supplying the convoluted irradiance map to the final shader.
         // ------------------------------------------------------------------------------------------
+        profiler.begin("spheres");
         pbrShader.use();
         glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        pbrShader.setMat4("view", view);
-        pbrShader.setVec3("camPos", camera.Position);
 
         // bind pre-computed IBL data
         glActiveTexture(GL_TEXTURE0);
@@ -514,15 +533,19 @@ int main()
             renderSphere();
         }
 
+        profiler.end();
+
         // render skybox (render as last to prevent overdraw)
+        profiler.begin("skybox");
         backgroundShader.use();
 
-        backgroundShader.setMat4("view", view);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
         //glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap); // display irradiance map
         //glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap); // display prefilter map
         renderCube();
+        profiler.end();
+        profiler.endFrame();
 
         // render BRDF map to screen
         //brdfShader.Use();
@@ -535,6 +558,10 @@ int main()
         glfwPollEvents();
     }
 
+    profiler.report(std::cout);
+    profiler.writeCSV("2.2.2.ibl_specular_textured.profile.csv");
+    profiler.writeChromeTrace("2.2.2.ibl_specular_textured.trace.json");
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
@@ -799,41 +826,10 @@ void renderQuad()
     glBindVertexArray(0);
 }
 
-// utility function for loading a 2D texture from file
-// ---------------------------------------------------
+// utility function for loading a 2D texture from file; the texture is decoded in the background
+// and holds a placeholder until TextureLoader::shared().update() uploads it
+// ---------------------------------------------------------------------------------------------
 unsigned int loadTexture(char const * path)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
+    return TextureCache::shared().acquire(path);
 }
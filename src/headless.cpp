@@ -0,0 +1,734 @@
+// Offscreen stand-in for the parts of GLFW the demos use, see includes/learnopengl/headless.h.
+// ------------------------------------------------------------------------------------------------------
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#ifdef LEARNOPENGL_HEADLESS_OSMESA
+#include <GL/osmesa.h>
+#endif
+#include <stb_image.h>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/headless.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// a keyframe of LOGL_CAMERA_PATH
+struct CameraKey
+{
+    float frame;
+    glm::vec3 position;
+    float yaw, pitch, zoom;
+};
+
+struct GLFWwindow
+{
+    int width, height;
+    int samples;
+    bool shouldClose;
+    // offscreen stand-in for the default framebuffer, multisampled if the demo asked for GLFW_SAMPLES
+    unsigned int FBO, colorBuffer, depthBuffer;
+    // single sample copy of it that captured frames are read back from
+    unsigned int resolveFBO, resolveColorBuffer;
+    GLFWframebuffersizefun framebufferSizeCallback;
+    GLFWkeyfun keyCallback;
+    GLFWcursorposfun cursorPosCallback;
+    GLFWscrollfun scrollCallback;
+};
+
+namespace
+{
+    // settings from the environment, read by glfwInit()
+    unsigned int frameCount = 60;
+    double timeStep = 1.0 / 60.0;
+    std::string outputDirectory;
+    std::string referenceDirectory;
+    double tolerance = 1.0;
+    bool captureAll = false;
+    std::vector<unsigned int> captureFrames;
+    std::vector<CameraKey> cameraPath;
+
+    // window hints of the next glfwCreateWindow()
+    int hintMajor = 3, hintMinor = 3, hintProfile = GLFW_OPENGL_ANY_PROFILE, hintSamples = 0;
+
+    // the context
+    bool useOSMesa = false;
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+#ifdef LEARNOPENGL_HEADLESS_OSMESA
+    OSMesaContext osmesaContext = NULL;
+    std::vector<unsigned char> osmesaBuffer;
+#endif
+    GLFWwindow *current = NULL;
+    Camera *attachedCamera = NULL;
+
+    // GL entry points the demos' calls to are redirected from the default framebuffer to the window's FBO
+    PFNGLBINDFRAMEBUFFERPROC realBindFramebuffer = NULL;
+    PFNGLDRAWBUFFERPROC realDrawBuffer = NULL;
+    PFNGLREADBUFFERPROC realReadBuffer = NULL;
+
+    // frame state and timing
+    unsigned int frame = 0;
+    std::chrono::steady_clock::time_point frameStart;
+    std::vector<double> frameTimes;
+    std::vector<std::string> failures;
+    std::vector<std::string> captureLog;
+
+    const char *environment(const char *name)
+    {
+        const char *value = std::getenv(name);
+        return value && *value ? value : NULL;
+    }
+
+    std::string outputPath(const std::string &directory, const std::string &name)
+    {
+        if (directory.empty())
+            return name;
+        return directory[directory.size() - 1] == '/' ? directory + name : directory + "/" + name;
+    }
+
+    std::string frameName(unsigned int index)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%04u.png", index);
+        return name;
+    }
+
+    bool loadCameraPath(const char *path)
+    {
+        std::ifstream file(path);
+        if (!file)
+            return false;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            line = line.substr(0, line.find('#'));
+            std::istringstream stream(line);
+            CameraKey key;
+            if (!(stream >> key.frame >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch))
+                continue;
+            if (!(stream >> key.zoom))
+                key.zoom = ZOOM;
+            cameraPath.push_back(key);
+        }
+        std::sort(cameraPath.begin(), cameraPath.end(), [](const CameraKey &a, const CameraKey &b) { return a.frame < b.frame; });
+        return true;
+    }
+
+    // moves the attached camera to the path's pose at the given frame
+    void applyCameraPath(unsigned int index)
+    {
+        if (!attachedCamera || cameraPath.empty())
+            return;
+        float f = (float)index;
+        unsigned int next = 0;
+        while (next < cameraPath.size() && cameraPath[next].frame <= f)
+            next++;
+        CameraKey key = cameraPath[next == 0 ? 0 : next - 1];
+        if (next > 0 && next < cameraPath.size())
+        {
+            const CameraKey &a = cameraPath[next - 1], &b = cameraPath[next];
+            float t = (f - a.frame) / (b.frame - a.frame);
+            key.position = glm::mix(a.position, b.position, t);
+            key.yaw = a.yaw + (b.yaw - a.yaw) * t;
+            key.pitch = a.pitch + (b.pitch - a.pitch) * t;
+            key.zoom = a.zoom + (b.zoom - a.zoom) * t;
+        }
+        attachedCamera->Position = key.position;
+        attachedCamera->Yaw = key.yaw;
+        attachedCamera->Pitch = key.pitch;
+        attachedCamera->Zoom = key.zoom;
+        attachedCamera->ProcessMouseMovement(0.0f, 0.0f); // recomputes the camera's vectors
+    }
+
+    // PNG with stored (uncompressed) deflate blocks; large, but needs no zlib
+    unsigned int crc32(unsigned int crc, const unsigned char *data, size_t size)
+    {
+        static unsigned int table[256];
+        if (table[1] == 0)
+            for (unsigned int n = 0; n < 256; n++)
+            {
+                unsigned int c = n;
+                for (int k = 0; k < 8; k++)
+                    c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++)
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void appendBigEndian(std::vector<unsigned char> &out, unsigned int value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back((unsigned char)(value >> shift));
+    }
+
+    void appendChunk(std::vector<unsigned char> &out, const char *type, const std::vector<unsigned char> &data)
+    {
+        appendBigEndian(out, (unsigned int)data.size());
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        appendBigEndian(out, crc32(0, &out[start], out.size() - start));
+    }
+
+    // rgb holds width * height RGB pixels, top row first
+    bool writePNG(const std::string &path, const std::vector<unsigned char> &rgb, int width, int height)
+    {
+        std::vector<unsigned char> raw;
+        raw.reserve((size_t)(width * 3 + 1) * height);
+        for (int y = 0; y < height; y++)
+        {
+            raw.push_back(0); // no filter
+            raw.insert(raw.end(), rgb.begin() + (size_t)y * width * 3, rgb.begin() + (size_t)(y + 1) * width * 3);
+        }
+        std::vector<unsigned char> zlib;
+        zlib.push_back(0x78);
+        zlib.push_back(0x01);
+        unsigned int a = 1, b = 0;
+        for (size_t offset = 0; offset < raw.size() || offset == 0; )
+        {
+            size_t size = std::min(raw.size() - offset, (size_t)65535);
+            zlib.push_back(offset + size == raw.size() ? 1 : 0);
+            zlib.push_back((unsigned char)(size & 0xff));
+            zlib.push_back((unsigned char)(size >> 8));
+            zlib.push_back((unsigned char)(~size & 0xff));
+            zlib.push_back((unsigned char)((~size >> 8) & 0xff));
+            for (size_t i = offset; i < offset + size; i++)
+            {
+                a = (a + raw[i]) % 65521;
+                b = (b + a) % 65521;
+            }
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+            offset += size;
+            if (size == 0)
+                break;
+        }
+        appendBigEndian(zlib, b << 16 | a);
+
+        std::vector<unsigned char> header;
+        appendBigEndian(header, (unsigned int)width);
+        appendBigEndian(header, (unsigned int)height);
+        header.push_back(8); // bit depth
+        header.push_back(2); // RGB
+        header.push_back(0);
+        header.push_back(0);
+        header.push_back(0);
+        const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        std::vector<unsigned char> png(signature, signature + 8);
+        appendChunk(png, "IHDR", header);
+        appendChunk(png, "IDAT", zlib);
+        appendChunk(png, "IEND", std::vector<unsigned char>());
+
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write((const char*)&png[0], png.size());
+        return (bool)out;
+    }
+
+    // whether stbi_load() currently flips images; the demos turn that on globally and texture loader threads may be
+    // reading the flag, so it's probed with a two row image instead of being changed
+    bool stbFlipsOnLoad()
+    {
+        const unsigned char image[] = { 'P', '5', '\n', '1', ' ', '2', '\n', '2', '5', '5', '\n', 0, 255 };
+        int width, height, channels;
+        unsigned char *pixels = stbi_load_from_memory(image, sizeof(image), &width, &height, &channels, 1);
+        bool flipped = pixels && pixels[0] == 255;
+        stbi_image_free(pixels);
+        return flipped;
+    }
+
+    bool shouldCapture(unsigned int index)
+    {
+        if (captureAll)
+            return true;
+        return std::find(captureFrames.begin(), captureFrames.end(), index) != captureFrames.end();
+    }
+
+    // reads the window's framebuffer back, saves it and compares it with its reference, leaving the demo's GL state as it was
+    void captureFrame(GLFWwindow *window, unsigned int index)
+    {
+        GLint drawFramebuffer, readFramebuffer, packBuffer, packAlignment;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+        glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+        glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+        GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+        glDisable(GL_SCISSOR_TEST);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+        unsigned int source = window->FBO;
+        if (window->resolveFBO)
+        {
+            realBindFramebuffer(GL_READ_FRAMEBUFFER, window->FBO);
+            realBindFramebuffer(GL_DRAW_FRAMEBUFFER, window->resolveFBO);
+            glBlitFramebuffer(0, 0, window->width, window->height, 0, 0, window->width, window->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            source = window->resolveFBO;
+        }
+        realBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+        std::vector<unsigned char> pixels((size_t)window->width * window->height * 3);
+        glReadPixels(0, 0, window->width, window->height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+
+        realBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+        realBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+        if (scissor)
+            glEnable(GL_SCISSOR_TEST);
+
+        // GL's rows start at the bottom
+        size_t rowSize = (size_t)window->width * 3;
+        for (int y = 0; y < window->height / 2; y++)
+            std::swap_ranges(pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize, pixels.begin() + (window->height - 1 - y) * rowSize);
+
+        std::string name = frameName(index);
+        std::ostringstream log;
+        log << "{ \"frame\": " << index << ", \"file\": \"" << name << "\"";
+        if (!writePNG(outputPath(outputDirectory, name), pixels, window->width, window->height))
+            failures.push_back("Failed to write " + outputPath(outputDirectory, name));
+
+        if (!referenceDirectory.empty())
+        {
+            int width, height, channels;
+            std::string referencePath = outputPath(referenceDirectory, name);
+            unsigned char *reference = stbi_load(referencePath.c_str(), &width, &height, &channels, 3);
+            if (!reference)
+                std::cout << "HEADLESS::No reference image " << referencePath << std::endl;
+            else
+            {
+                double difference = 255.0;
+                if (width == window->width && height == window->height)
+                {
+                    bool flipped = stbFlipsOnLoad();
+                    double sum = 0.0;
+                    for (int y = 0; y < height; y++)
+                    {
+                        const unsigned char *row = &pixels[y * rowSize];
+                        const unsigned char *referenceRow = reference + (flipped ? height - 1 - y : y) * rowSize;
+                        for (size_t i = 0; i < rowSize; i++)
+                            sum += std::abs((int)row[i] - (int)referenceRow[i]);
+                    }
+                    difference = sum / pixels.size();
+                }
+                stbi_image_free(reference);
+                log << ", \"difference\": " << difference;
+                if (difference > tolerance)
+                {
+                    std::ostringstream failure;
+                    failure << name << " differs from " << referencePath << " by " << difference << " on average";
+                    failures.push_back(failure.str());
+                }
+            }
+        }
+        log << " }";
+        captureLog.push_back(log.str());
+    }
+
+    void writeTiming()
+    {
+        std::ofstream out(outputPath(outputDirectory, "timing.json").c_str(), std::ios::trunc);
+        if (!out)
+        {
+            failures.push_back("Failed to write " + outputPath(outputDirectory, "timing.json"));
+            return;
+        }
+        std::vector<double> sorted(frameTimes);
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (unsigned int i = 0; i < frameTimes.size(); i++)
+            total += frameTimes[i];
+        const char *renderer = current ? (const char*)glGetString(GL_RENDERER) : NULL;
+        const char *version = current ? (const char*)glGetString(GL_VERSION) : NULL;
+        out << "{\n";
+        out << "  \"backend\": \"" << (useOSMesa ? "osmesa" : "egl") << "\",\n";
+        out << "  \"renderer\": \"" << (renderer ? renderer : "") << "\",\n";
+        out << "  \"version\": \"" << (version ? version : "") << "\",\n";
+        out << "  \"width\": " << (current ? current->width : 0) << ",\n";
+        out << "  \"height\": " << (current ? current->height : 0) << ",\n";
+        out << "  \"frames\": " << frameTimes.size() << ",\n";
+        out << "  \"total_ms\": " << total << ",\n";
+        out << "  \"mean_ms\": " << (sorted.empty() ? 0.0 : total / sorted.size()) << ",\n";
+        out << "  \"median_ms\": " << (sorted.empty() ? 0.0 : sorted[sorted.size() / 2]) << ",\n";
+        out << "  \"min_ms\": " << (sorted.empty() ? 0.0 : sorted.front()) << ",\n";
+        out << "  \"max_ms\": " << (sorted.empty() ? 0.0 : sorted.back()) << ",\n";
+        out << "  \"frame_ms\": [";
+        for (unsigned int i = 0; i < frameTimes.size(); i++)
+            out << (i ? ", " : "") << frameTimes[i];
+        out << "],\n";
+        out << "  \"captures\": [";
+        for (unsigned int i = 0; i < captureLog.size(); i++)
+            out << (i ? ",\n    " : "\n    ") << captureLog[i];
+        out << (captureLog.empty() ? "]\n" : "\n  ]\n");
+        out << "}\n";
+        out.flush();
+        if (!out)
+            failures.push_back("Failed to write " + outputPath(outputDirectory, "timing.json"));
+    }
+
+    // the demos bind framebuffer 0 to draw to the window, which is the window's FBO here
+    void APIENTRY bindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        realBindFramebuffer(target, framebuffer == 0 && current ? current->FBO : framebuffer);
+    }
+    // GL_BACK/GL_FRONT only exist on a real default framebuffer; an application FBO would reject them anyway
+    GLenum colorBufferOf(GLenum buffer)
+    {
+        if (buffer == GL_BACK || buffer == GL_FRONT || buffer == GL_BACK_LEFT || buffer == GL_FRONT_LEFT || buffer == GL_FRONT_AND_BACK)
+            return GL_COLOR_ATTACHMENT0;
+        return buffer;
+    }
+    void APIENTRY drawBuffer(GLenum buffer)
+    {
+        realDrawBuffer(colorBufferOf(buffer));
+    }
+    void APIENTRY readBuffer(GLenum buffer)
+    {
+        realReadBuffer(colorBufferOf(buffer));
+    }
+
+    GLFWglproc lookupProcAddress(const char *name)
+    {
+#ifdef LEARNOPENGL_HEADLESS_OSMESA
+        if (useOSMesa)
+            return (GLFWglproc)OSMesaGetProcAddress(name);
+#endif
+        return (GLFWglproc)eglGetProcAddress(name);
+    }
+
+    bool createEGLContext()
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+            return false;
+        const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+            return false;
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, hintMajor,
+            EGL_CONTEXT_MINOR_VERSION, hintMinor,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, hintProfile == GLFW_OPENGL_COMPAT_PROFILE ? EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT : EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        return context != EGL_NO_CONTEXT;
+    }
+
+#ifdef LEARNOPENGL_HEADLESS_OSMESA
+    bool createOSMesaContext()
+    {
+        const int attributes[] = {
+            OSMESA_FORMAT, OSMESA_RGBA,
+            OSMESA_DEPTH_BITS, 24,
+            OSMESA_STENCIL_BITS, 8,
+            OSMESA_PROFILE, hintProfile == GLFW_OPENGL_COMPAT_PROFILE ? OSMESA_COMPAT_PROFILE : OSMESA_CORE_PROFILE,
+            OSMESA_CONTEXT_MAJOR_VERSION, hintMajor,
+            OSMESA_CONTEXT_MINOR_VERSION, hintMinor,
+            0
+        };
+        osmesaContext = OSMesaCreateContextAttribs(attributes, NULL);
+        return osmesaContext != NULL;
+    }
+#endif
+
+    // creates the window's offscreen framebuffer; the context must be current
+    bool createFramebuffer(GLFWwindow *window)
+    {
+        glGenFramebuffers(1, &window->FBO);
+        glGenRenderbuffers(1, &window->colorBuffer);
+        glGenRenderbuffers(1, &window->depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, window->colorBuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, window->samples, GL_RGBA8, window->width, window->height);
+        glBindRenderbuffer(GL_RENDERBUFFER, window->depthBuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, window->samples, GL_DEPTH24_STENCIL8, window->width, window->height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        realBindFramebuffer(GL_FRAMEBUFFER, window->FBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, window->colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, window->depthBuffer);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (window->samples > 0)
+        {
+            glGenFramebuffers(1, &window->resolveFBO);
+            glGenRenderbuffers(1, &window->resolveColorBuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, window->resolveColorBuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, window->width, window->height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            realBindFramebuffer(GL_FRAMEBUFFER, window->resolveFBO);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, window->resolveColorBuffer);
+            complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        }
+        realBindFramebuffer(GL_FRAMEBUFFER, window->FBO);
+        glViewport(0, 0, window->width, window->height);
+        return complete;
+    }
+}
+
+void headlessAttachCamera(Camera *camera)
+{
+    attachedCamera = camera;
+}
+
+int glfwInit(void)
+{
+    if (const char *value = environment("LOGL_FRAMES"))
+        frameCount = (unsigned int)std::max(1, std::atoi(value));
+    if (const char *value = environment("LOGL_TIME_STEP"))
+        timeStep = std::atof(value);
+    if (const char *value = environment("LOGL_OUTPUT"))
+        outputDirectory = value;
+    if (const char *value = environment("LOGL_REFERENCE"))
+        referenceDirectory = value;
+    if (const char *value = environment("LOGL_TOLERANCE"))
+        tolerance = std::atof(value);
+    const char *capture = environment("LOGL_CAPTURE");
+    if (!capture)
+        captureFrames.push_back(frameCount - 1);
+    else if (std::string(capture) == "all")
+        captureAll = true;
+    else if (std::string(capture) != "none")
+    {
+        std::istringstream stream(capture);
+        std::string index;
+        while (std::getline(stream, index, ','))
+            captureFrames.push_back((unsigned int)std::atoi(index.c_str()));
+    }
+    if (const char *path = environment("LOGL_CAMERA_PATH"))
+        if (!loadCameraPath(path))
+            std::cout << "ERROR::HEADLESS::Failed to read camera path " << path << std::endl;
+
+    const char *backend = environment("LOGL_BACKEND");
+    useOSMesa = backend && std::string(backend) == "osmesa";
+#ifndef LEARNOPENGL_HEADLESS_OSMESA
+    if (useOSMesa)
+    {
+        std::cout << "ERROR::HEADLESS::Built without OSMesa" << std::endl;
+        return GL_FALSE;
+    }
+#endif
+    return GL_TRUE;
+}
+
+void glfwTerminate(void)
+{
+    if (!current)
+        return;
+    writeTiming();
+    glDeleteFramebuffers(1, &current->FBO);
+    glDeleteRenderbuffers(1, &current->colorBuffer);
+    glDeleteRenderbuffers(1, &current->depthBuffer);
+    if (current->resolveFBO)
+    {
+        glDeleteFramebuffers(1, &current->resolveFBO);
+        glDeleteRenderbuffers(1, &current->resolveColorBuffer);
+    }
+    delete current;
+    current = NULL;
+#ifdef LEARNOPENGL_HEADLESS_OSMESA
+    if (osmesaContext)
+        OSMesaDestroyContext(osmesaContext);
+    osmesaContext = NULL;
+#endif
+    if (display != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        eglTerminate(display);
+    }
+    context = EGL_NO_CONTEXT;
+    display = EGL_NO_DISPLAY;
+
+    // the demos always exit with 0, a frame that doesn't match its reference or an output that couldn't be written
+    // has to fail the run from here
+    if (!failures.empty())
+    {
+        for (unsigned int i = 0; i < failures.size(); i++)
+            std::cout << "ERROR::HEADLESS::" << failures[i] << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+void glfwWindowHint(int target, int hint)
+{
+    if (target == GLFW_CONTEXT_VERSION_MAJOR)
+        hintMajor = hint;
+    else if (target == GLFW_CONTEXT_VERSION_MINOR)
+        hintMinor = hint;
+    else if (target == GLFW_OPENGL_PROFILE)
+        hintProfile = hint;
+    else if (target == GLFW_SAMPLES)
+        hintSamples = hint;
+}
+
+GLFWwindow* glfwCreateWindow(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share)
+{
+    (void)title; (void)monitor; (void)share;
+    if (current)
+    {
+        std::cout << "ERROR::HEADLESS::Only one window is supported" << std::endl;
+        return NULL;
+    }
+    bool created = false;
+#ifdef LEARNOPENGL_HEADLESS_OSMESA
+    if (!useOSMesa && !createEGLContext())
+    {
+        std::cout << "HEADLESS::No EGL context, falling back to OSMesa" << std::endl;
+        useOSMesa = true;
+    }
+    created = useOSMesa ? createOSMesaContext() : true;
+#else
+    created = createEGLContext();
+#endif
+    if (!created)
+    {
+        std::cout << "ERROR::HEADLESS::Failed to create an OpenGL " << hintMajor << "." << hintMinor << " context" << std::endl;
+        return NULL;
+    }
+
+    GLFWwindow *window = new GLFWwindow();
+    window->width = width;
+    window->height = height;
+    window->samples = hintSamples;
+    current = window;
+    return window;
+}
+
+void glfwMakeContextCurrent(GLFWwindow* window)
+{
+    if (!window)
+        return;
+    bool madeCurrent;
+#ifdef LEARNOPENGL_HEADLESS_OSMESA
+    if (useOSMesa)
+    {
+        // OSMesa insists on a buffer of its own even though everything is drawn into the window's FBO
+        osmesaBuffer.resize((size_t)window->width * window->height * 4);
+        madeCurrent = OSMesaMakeCurrent(osmesaContext, &osmesaBuffer[0], GL_UNSIGNED_BYTE, window->width, window->height) != 0;
+    }
+    else
+#endif
+        madeCurrent = eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) != EGL_FALSE;
+    if (!madeCurrent)
+    {
+        std::cout << "ERROR::HEADLESS::Failed to make the context current" << std::endl;
+        return;
+    }
+    if (window->FBO)
+        return;
+
+    // the demo's GL loader isn't set up yet, load what the window's framebuffer needs for ourselves
+    if (!gladLoadGLLoader((GLADloadproc)lookupProcAddress))
+        return;
+    realBindFramebuffer = glad_glBindFramebuffer;
+    realDrawBuffer = glad_glDrawBuffer;
+    realReadBuffer = glad_glReadBuffer;
+    if (!createFramebuffer(window))
+        std::cout << "ERROR::HEADLESS::Offscreen framebuffer is not complete" << std::endl;
+    applyCameraPath(0);
+    frameStart = std::chrono::steady_clock::now();
+}
+
+GLFWglproc glfwGetProcAddress(const char* procname)
+{
+    if (std::strcmp(procname, "glBindFramebuffer") == 0)
+        return (GLFWglproc)bindFramebuffer;
+    if (std::strcmp(procname, "glDrawBuffer") == 0)
+        return (GLFWglproc)drawBuffer;
+    if (std::strcmp(procname, "glReadBuffer") == 0)
+        return (GLFWglproc)readBuffer;
+    return lookupProcAddress(procname);
+}
+
+int glfwWindowShouldClose(GLFWwindow* window)
+{
+    return window->shouldClose || frame >= frameCount;
+}
+
+void glfwSetWindowShouldClose(GLFWwindow* window, int value)
+{
+    window->shouldClose = value != 0;
+}
+
+void glfwSwapBuffers(GLFWwindow* window)
+{
+    glFinish();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    frameTimes.push_back(std::chrono::duration<double, std::milli>(end - frameStart).count());
+    if (shouldCapture(frame))
+        captureFrame(window, frame);
+    frame++;
+    applyCameraPath(frame);
+    frameStart = std::chrono::steady_clock::now();
+}
+
+void glfwPollEvents(void)
+{
+}
+
+double glfwGetTime(void)
+{
+    return frame * timeStep;
+}
+
+int glfwGetKey(GLFWwindow* window, int key)
+{
+    (void)window; (void)key;
+    return GLFW_RELEASE;
+}
+
+void glfwSetInputMode(GLFWwindow* window, int mode, int value)
+{
+    (void)window; (void)mode; (void)value;
+}
+
+void glfwGetFramebufferSize(GLFWwindow* window, int* width, int* height)
+{
+    if (width)
+        *width = window->width;
+    if (height)
+        *height = window->height;
+}
+
+GLFWframebuffersizefun glfwSetFramebufferSizeCallback(GLFWwindow* window, GLFWframebuffersizefun cbfun)
+{
+    std::swap(window->framebufferSizeCallback, cbfun);
+    return cbfun;
+}
+
+GLFWkeyfun glfwSetKeyCallback(GLFWwindow* window, GLFWkeyfun cbfun)
+{
+    std::swap(window->keyCallback, cbfun);
+    return cbfun;
+}
+
+GLFWcursorposfun glfwSetCursorPosCallback(GLFWwindow* window, GLFWcursorposfun cbfun)
+{
+    std::swap(window->cursorPosCallback, cbfun);
+    return cbfun;
+}
+
+GLFWscrollfun glfwSetScrollCallback(GLFWwindow* window, GLFWscrollfun cbfun)
+{
+    std::swap(window->scrollCallback, cbfun);
+    return cbfun;
+}
@@ -0,0 +1,157 @@
+// Checks the vertex cache optimization on the bundled models without a GL context or Assimp: every OBJ named on the
+// command line is split into one mesh per material and triangulated with a vertex per face corner, the way the
+// importer hands it to Model, welded, and then optimizeVertexCache() must not make any mesh's ACMR worse than the
+// order the file came in. Prints ACMR/ATVR before and after per model; exits with 1 if a mesh got worse.
+#include <learnopengl/mesh_optimizer.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+struct ObjMesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// OBJ indices are 1-based, negative ones count back from the last element read so far
+static int resolveIndex(const std::string &text, size_t count)
+{
+    if (text.empty())
+        return -1;
+    int index = std::atoi(text.c_str());
+    return index < 0 ? (int)count + index : index - 1;
+}
+
+static bool loadObj(const std::string &path, std::vector<ObjMesh> &meshes)
+{
+    std::ifstream in(path.c_str());
+    if (!in)
+    {
+        std::cout << "ERROR::VERTEX_CACHE_CHECK::Could not read " << path << std::endl;
+        return false;
+    }
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> texCoords;
+    std::map<std::string, unsigned int> materials; // material -> index into meshes
+    ObjMesh *mesh = NULL;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword))
+            continue;
+        if (keyword == "v")
+        {
+            glm::vec3 position;
+            words >> position.x >> position.y >> position.z;
+            positions.push_back(position);
+        }
+        else if (keyword == "vn")
+        {
+            glm::vec3 normal;
+            words >> normal.x >> normal.y >> normal.z;
+            normals.push_back(normal);
+        }
+        else if (keyword == "vt")
+        {
+            glm::vec2 texCoord;
+            words >> texCoord.x >> texCoord.y;
+            texCoords.push_back(texCoord);
+        }
+        else if (keyword == "usemtl" || (keyword == "f" && mesh == NULL))
+        {
+            std::string material;
+            if (keyword == "usemtl")
+                words >> material;
+            std::map<std::string, unsigned int>::iterator it = materials.find(material);
+            if (it == materials.end())
+            {
+                it = materials.insert(std::make_pair(material, (unsigned int)meshes.size())).first;
+                meshes.push_back(ObjMesh());
+            }
+            mesh = &meshes[it->second];
+        }
+        if (keyword != "f")
+            continue;
+        // one vertex per corner, fanned into triangles like aiProcess_Triangulate does
+        std::vector<unsigned int> corners;
+        std::string corner;
+        while (words >> corner)
+        {
+            std::string parts[3];
+            std::istringstream fields(corner);
+            for (int i = 0; i < 3 && std::getline(fields, parts[i], '/'); i++)
+                ;
+            int p = resolveIndex(parts[0], positions.size());
+            int t = resolveIndex(parts[1], texCoords.size());
+            int n = resolveIndex(parts[2], normals.size());
+            if (p < 0 || p >= (int)positions.size() || t >= (int)texCoords.size() || n >= (int)normals.size())
+            {
+                std::cout << "ERROR::VERTEX_CACHE_CHECK::Bad face in " << path << ": " << line << std::endl;
+                return false;
+            }
+            Vertex vertex = Vertex();
+            vertex.Position = positions[p];
+            if (t >= 0)
+                vertex.TexCoords = texCoords[t];
+            if (n >= 0)
+                vertex.Normal = normals[n];
+            corners.push_back((unsigned int)mesh->vertices.size());
+            mesh->vertices.push_back(vertex);
+        }
+        for (size_t i = 2; i < corners.size(); i++)
+        {
+            mesh->indices.push_back(corners[0]);
+            mesh->indices.push_back(corners[i - 1]);
+            mesh->indices.push_back(corners[i]);
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: vertex_cache_check model.obj..." << std::endl;
+        return 1;
+    }
+    bool worse = false;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int arg = 1; arg < argc; arg++)
+    {
+        std::vector<ObjMesh> meshes;
+        if (!loadObj(argv[arg], meshes))
+            return 1;
+        VertexCacheStats before, after;
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            ObjMesh &mesh = meshes[i];
+            if (mesh.indices.empty())
+                continue;
+            // unwelded every corner is a miss, welding is what gives the cache something to hit
+            unsigned int vertexCount = weldVertices(mesh.vertices, mesh.indices);
+            VertexCacheStats meshBefore = analyzeVertexCache(mesh.indices, vertexCount);
+            optimizeVertexCache(mesh.indices, vertexCount);
+            VertexCacheStats meshAfter = analyzeVertexCache(mesh.indices, vertexCount);
+            if (meshAfter.transforms > meshBefore.transforms)
+            {
+                std::cout << "ERROR::VERTEX_CACHE_CHECK::" << argv[arg] << " mesh " << i << " ACMR got worse: " << meshBefore.acmr()
+                          << " -> " << meshAfter.acmr() << std::endl;
+                worse = true;
+            }
+            before.add(meshBefore);
+            after.add(meshAfter);
+        }
+        std::cout << argv[arg] << ": " << meshes.size() << " meshes, " << before.triangles << " triangles, ACMR " << before.acmr() << " -> "
+                  << after.acmr() << ", ATVR " << before.atvr() << " -> " << after.atvr() << std::endl;
+    }
+    return worse ? 1 : 0;
+}